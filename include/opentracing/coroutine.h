@@ -0,0 +1,277 @@
+#ifndef OPENTRACING_COROUTINE_H
+#define OPENTRACING_COROUTINE_H
+
+// Support for keeping a span active across the suspension points of C++20
+// coroutines. Only available when the compiler supports coroutines, in which
+// case OPENTRACING_HAS_COROUTINES is defined.
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define OPENTRACING_HAS_COROUTINES 1
+#endif
+#endif
+
+#include <opentracing/symbols.h>
+#include <opentracing/version.h>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+class Span;
+
+// CoroutineHandoff records that a coroutine running with `span` active passed
+// the calling thread on to other code while suspending, and that
+// `previous_span` is to be made active once the thread is given back. It's
+// used by CoroutineScope.
+struct CoroutineHandoff {
+  const Span* span;
+  Span* previous_span;
+};
+
+// Returns the calling thread's CoroutineHandoff. It's defined in the library,
+// so that every shared library in the process sees the same one.
+OPENTRACING_API CoroutineHandoff& GetCoroutineHandoff() noexcept;
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#ifdef OPENTRACING_HAS_COROUTINES
+
+#include <opentracing/scope_manager.h>
+#include <opentracing/span.h>
+#include <opentracing/util.h>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+template <class Awaitable>
+class CoroutineSpanAwaiter;
+
+// CoroutineScope keeps a span active while a coroutine runs, which a Scope
+// can't do: a Scope would stay open on the thread where the coroutine
+// suspends, and be closed on whichever thread resumes it.
+//
+// The span is made active when the CoroutineScope is constructed and while
+// the coroutine is running. Each suspension point must await through Await,
+// which restores the thread's previous active span once the coroutine gives
+// up the thread. When the coroutine resumes, on any thread, the span becomes
+// active again. For example:
+//
+//     Task<Response> Handle(Request request) {
+//       auto span = tracer.StartSpan("Handle",
+//                                    {opentracing::ChildOfActiveSpan{}});
+//       opentracing::CoroutineScope scope{*span};
+//       auto data = co_await scope.Await(Fetch(request));
+//       co_return MakeResponse(data);
+//     }
+//
+// If the awaited object runs another coroutine, such as a lazily started
+// task, either from its await_suspend or by returning the coroutine's handle
+// from it, that coroutine starts with the span active. Such a coroutine
+// should also use a CoroutineScope if it may suspend: the CoroutineScope
+// gives the thread its previous span back when it suspends, which a plain
+// coroutine can't.
+//
+// CoroutineScope also measures how long the span's coroutine spent running
+// and suspended. When it's destroyed, it sets the tags
+// "coroutine.running_us" and "coroutine.suspended_us" on the span, in
+// microseconds. The span must outlive the CoroutineScope.
+class CoroutineScope {
+ public:
+  explicit CoroutineScope(Span& span) noexcept : span_{span} { Resume(); }
+
+  CoroutineScope(const CoroutineScope&) = delete;
+  CoroutineScope& operator=(const CoroutineScope&) = delete;
+
+  ~CoroutineScope() {
+    Suspend();
+    span_.SetTag("coroutine.running_us", ToMicroseconds(running_duration_));
+    span_.SetTag("coroutine.suspended_us",
+                 ToMicroseconds(suspended_duration_));
+  }
+
+  Span& span() const noexcept { return span_; }
+
+  // Returns an awaitable that awaits `awaitable` with the span deactivated
+  // while the coroutine is suspended.
+  template <class Awaitable>
+  CoroutineSpanAwaiter<Awaitable> Await(Awaitable&& awaitable) {
+    return CoroutineSpanAwaiter<Awaitable>{
+        *this, std::forward<Awaitable>(awaitable)};
+  }
+
+  // Returns how long the coroutine has run with the span active, excluding
+  // the current run.
+  SteadyClock::duration running_duration() const noexcept {
+    return running_duration_;
+  }
+
+  // Returns how long the coroutine has been suspended, excluding the current
+  // suspension.
+  SteadyClock::duration suspended_duration() const noexcept {
+    return suspended_duration_;
+  }
+
+ private:
+  template <class Awaitable>
+  friend class CoroutineSpanAwaiter;
+
+  Span& span_;
+  Span* previous_span_ = nullptr;
+  bool is_running_ = false;
+  SteadyTime last_timestamp_;
+  SteadyClock::duration running_duration_ = SteadyClock::duration::zero();
+  SteadyClock::duration suspended_duration_ = SteadyClock::duration::zero();
+
+  static uint64_t ToMicroseconds(SteadyClock::duration duration) noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count());
+  }
+
+  // Called on the thread that runs the coroutine from here on.
+  void Resume() noexcept {
+    if (is_running_) {
+      return;
+    }
+    auto now = SteadyClock::now();
+    if (last_timestamp_ != SteadyTime{}) {
+      suspended_duration_ += now - last_timestamp_;
+    }
+    last_timestamp_ = now;
+    auto previous_span = ScopeManager::SetActiveSpan(&span_);
+    // If the active span is that of a coroutine that handed the thread over,
+    // this coroutine was started or resumed from within its suspension, and
+    // the thread's span is the one that coroutine replaced.
+    auto& handoff = GetCoroutineHandoff();
+    if (previous_span != nullptr && previous_span == handoff.span) {
+      previous_span = handoff.previous_span;
+      handoff = CoroutineHandoff{nullptr, nullptr};
+    }
+    previous_span_ = previous_span;
+    is_running_ = true;
+  }
+
+  // Called on the thread the coroutine is about to stop running on. Returns
+  // the span the thread had active before the coroutine, without activating
+  // it.
+  Span* StopRunning() noexcept {
+    auto now = SteadyClock::now();
+    running_duration_ += now - last_timestamp_;
+    last_timestamp_ = now;
+    is_running_ = false;
+    return previous_span_;
+  }
+
+  void Suspend() noexcept {
+    if (!is_running_) {
+      return;
+    }
+    ScopeManager::SetActiveSpan(StopRunning());
+  }
+};
+
+// CoroutineSpanAwaiter is returned by CoroutineScope::Await, and forwards to
+// the awaiter of the wrapped awaitable.
+template <class Awaitable>
+class CoroutineSpanAwaiter {
+ public:
+  CoroutineSpanAwaiter(CoroutineScope& scope, Awaitable&& awaitable)
+      : scope_{scope},
+        awaiter_(GetAwaiter(std::forward<Awaitable>(awaitable))) {}
+
+  bool await_ready() { return awaiter_.await_ready(); }
+
+  template <class Promise>
+  auto await_suspend(std::coroutine_handle<Promise> handle) {
+    using Result = decltype(awaiter_.await_suspend(handle));
+    // Once the wrapped awaiter has the handle, the coroutine may be resumed
+    // on another thread at any time, so the scope is stopped beforehand and
+    // not touched again unless the coroutine doesn't suspend. The span stays
+    // active until the thread is given back, so that coroutines the awaiter
+    // starts run as its children.
+    auto& span = scope_.span_;
+    auto previous_span = scope_.StopRunning();
+    GetCoroutineHandoff() = CoroutineHandoff{&span, previous_span};
+    try {
+      if constexpr (std::is_void_v<Result>) {
+        awaiter_.await_suspend(handle);
+        GiveBackThread(span, previous_span);
+      } else if constexpr (std::is_same_v<Result, bool>) {
+        auto should_suspend = awaiter_.await_suspend(handle);
+        if (!should_suspend) {
+          ResumeWithoutSuspending(previous_span);
+          return false;
+        }
+        GiveBackThread(span, previous_span);
+        return true;
+      } else {
+        std::coroutine_handle<> next = awaiter_.await_suspend(handle);
+        // The thread moves on to the returned coroutine, which starts with
+        // the span active, unless it's a no-op.
+        if (next == std::noop_coroutine()) {
+          GiveBackThread(span, previous_span);
+        }
+        return next;
+      }
+    } catch (...) {
+      ResumeWithoutSuspending(previous_span);
+      throw;
+    }
+  }
+
+  decltype(auto) await_resume() {
+    scope_.Resume();
+    return awaiter_.await_resume();
+  }
+
+ private:
+  template <class T>
+  static decltype(auto) GetAwaiter(T&& awaitable) {
+    if constexpr (requires {
+                    std::forward<T>(awaitable).operator co_await();
+                  }) {
+      return std::forward<T>(awaitable).operator co_await();
+    } else if constexpr (requires {
+                           operator co_await(std::forward<T>(awaitable));
+                         }) {
+      return operator co_await(std::forward<T>(awaitable));
+    } else {
+      return std::forward<T>(awaitable);
+    }
+  }
+
+  // Restores the span the thread had active before the coroutine.
+  static void GiveBackThread(const Span& span, Span* previous_span) noexcept {
+    auto& handoff = GetCoroutineHandoff();
+    if (handoff.span == &span) {
+      handoff = CoroutineHandoff{nullptr, nullptr};
+    }
+    ScopeManager::SetActiveSpan(previous_span);
+  }
+
+  void ResumeWithoutSuspending(Span* previous_span) noexcept {
+    GetCoroutineHandoff() = CoroutineHandoff{nullptr, nullptr};
+    ScopeManager::SetActiveSpan(previous_span);
+    scope_.Resume();
+  }
+
+  using AwaiterResult = decltype(GetAwaiter(std::declval<Awaitable>()));
+
+  // Awaiters returned by value, or passed as temporaries, are stored by
+  // value; those passed as lvalues are referenced.
+  using Awaiter =
+      std::conditional_t<std::is_lvalue_reference_v<AwaiterResult>,
+                         AwaiterResult, std::remove_cvref_t<AwaiterResult>>;
+
+  CoroutineScope& scope_;
+  Awaiter awaiter_;
+};
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_HAS_COROUTINES
+
+#endif  // OPENTRACING_COROUTINE_H
@@ -0,0 +1,121 @@
+#ifndef OPENTRACING_SCOPE_MANAGER_H
+#define OPENTRACING_SCOPE_MANAGER_H
+
+#include <opentracing/span.h>
+#include <opentracing/symbols.h>
+#include <opentracing/tracer.h>
+#include <opentracing/version.h>
+#include <memory>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+// Scope keeps a Span active on the thread that activated it until the Scope
+// is closed or destroyed, at which point the span that was active before it
+// becomes active again.
+//
+// Scopes on a thread must be closed in the reverse order they were opened,
+// which keeping them in local variables ensures, and on the thread that
+// opened them. The span must outlive the Scope; closing the Scope doesn't
+// finish it. So must the shared_ptr a span was activated through, which the
+// Scope refers to rather than copies.
+class OPENTRACING_API Scope {
+ public:
+  Scope(Scope&& other) noexcept;
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  ~Scope();
+
+  Span& span() const noexcept { return *span_; }
+
+  // Deactivates the span before the Scope is destroyed. Does nothing if the
+  // Scope is already closed.
+  void Close() noexcept;
+
+ private:
+  friend class ScopeManager;
+
+  Scope(Span& span, Span* previous_span,
+        const std::shared_ptr<Span>* previous_owner) noexcept
+      : span_{&span},
+        previous_span_{previous_span},
+        previous_owner_{previous_owner},
+        is_open_{true} {}
+
+  Span* span_;
+  Span* previous_span_;
+  const std::shared_ptr<Span>* previous_owner_;
+  bool is_open_;
+};
+
+// ScopeManager tracks the active span of each thread, so that code can find
+// the span it runs in without it being passed down the call stack.
+//
+// The active spans of a thread form a stack whose nodes are the Scopes
+// themselves: each remembers the span that was active before it, and the
+// thread only stores a pointer to the top span. Activating and looking up
+// spans involves no allocation, locking or shared state.
+class OPENTRACING_API ScopeManager {
+ public:
+  // Makes `span` the active span of the calling thread until the returned
+  // Scope is closed.
+  static Scope Activate(Span& span) noexcept;
+
+  // Like Activate(Span&), but also lets ActiveSpanOwner share ownership of
+  // the span while it's active, so that code such as TaskContext can keep it
+  // alive without copying its context. `span` must not be null.
+  static Scope Activate(const std::shared_ptr<Span>& span) noexcept;
+
+  // The shared_ptr would be destroyed before the Scope.
+  static Scope Activate(std::shared_ptr<Span>&& span) = delete;
+
+  // Returns the active span of the calling thread, or nullptr if there's
+  // none.
+  static Span* ActiveSpan() noexcept;
+
+  // Returns the active span of the calling thread if it was activated through
+  // a shared_ptr, or nullptr otherwise.
+  static std::shared_ptr<Span> ActiveSpanOwner() noexcept;
+
+  // Makes `span` the active span of the calling thread without a Scope, and
+  // returns the span that was active. This is for code that tracks when a
+  // span stops and starts running itself, such as coroutine integrations;
+  // the previous span must be restored the same way. The span set this way
+  // has no owner for ActiveSpanOwner to return.
+  static Span* SetActiveSpan(Span* span) noexcept;
+};
+
+// ChildOfActiveSpan is a StartSpanOption that makes the new span a child of
+// the calling thread's active span. If no span is active, it's ignored, and
+// the new span starts a trace unless other options reference a parent.
+//
+// For example:
+//
+//     auto span = tracer.StartSpan("GetFeed",
+//                                  {opentracing::ChildOfActiveSpan{}});
+//     auto scope = opentracing::ScopeManager::Activate(*span);
+class ChildOfActiveSpan : public StartSpanOption {
+ public:
+  ChildOfActiveSpan() noexcept = default;
+
+  ChildOfActiveSpan(const ChildOfActiveSpan& /*other*/) noexcept
+      : StartSpanOption() {}
+
+  void Apply(StartSpanOptions& options) const noexcept override {
+    auto span = ScopeManager::ActiveSpan();
+    if (span == nullptr) {
+      return;
+    }
+    try {
+      options.references.emplace_back(SpanReferenceType::ChildOfRef,
+                                      &span->context());
+    } catch (const std::bad_alloc&) {
+      // Ignore reference if memory can't be allocated for it.
+    }
+  }
+};
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_SCOPE_MANAGER_H
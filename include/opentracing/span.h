@@ -51,6 +51,12 @@ class SpanContext {
   // functionality or an error occurs (this is the case for no-op traces, for
   // example).
   virtual std::string ToSpanID() const noexcept { return {}; }
+
+  // Returns false if spans in this context's trace are discarded, for example
+  // because the trace wasn't sampled.
+  //
+  // Tracers that don't sample can rely on the default, which returns true.
+  virtual bool IsSampled() const noexcept { return true; }
 };
 
 struct LogRecord {
@@ -189,6 +195,16 @@ class Span {
 
   // Provides access to the Tracer that created this Span.
   virtual const Tracer& tracer() const noexcept = 0;
+
+  // Returns false if the span's operation name, tags, logs and baggage are
+  // discarded, so that instrumentation can skip computing expensive values:
+  //
+  //    if (span->IsRecording()) {
+  //      span->SetTag("http.request.body", FormatBody(request));
+  //    }
+  //
+  // The default returns context().IsSampled().
+  virtual bool IsRecording() const noexcept { return context().IsSampled(); }
 };
 
 // FinishTimestamp is a FinishSpanOption that sets an explicit finish timestamp
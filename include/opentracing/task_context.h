@@ -0,0 +1,129 @@
+#ifndef OPENTRACING_TASK_CONTEXT_H
+#define OPENTRACING_TASK_CONTEXT_H
+
+#include <opentracing/scope_manager.h>
+#include <opentracing/span.h>
+#include <opentracing/string_view.h>
+#include <opentracing/symbols.h>
+#include <opentracing/tracer.h>
+#include <opentracing/version.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+struct TaskContextOptions {
+  // The tracer that starts the queue wait and run spans, which the
+  // TaskContext keeps alive. If null, Tracer::Global() is used.
+  std::shared_ptr<const Tracer> tracer;
+
+  // If not empty, a span with this operation name is recorded for the time
+  // between the task's submission and the start of its execution.
+  std::string queue_wait_operation_name;
+
+  // If not empty, a span with this operation name is recorded for each
+  // execution of the task, and is the active span while it runs.
+  std::string run_operation_name;
+};
+
+// TaskContext carries the active span of the thread that submits a task to
+// the thread that runs it, such as a thread pool worker.
+//
+// If the active span was activated through a shared_ptr, the TaskContext
+// shares ownership of it, and the span itself is active while the task runs.
+// Otherwise it captures a clone of the span's context, and a span standing in
+// for that context is active instead, so spans started with ChildOfActiveSpan
+// become its children; the stand-in's tag, log and finish calls are ignored,
+// and its tracer is the options' tracer. If no span was active at submission,
+// nothing is captured, and running the task leaves the active span alone.
+// Copies of a TaskContext share what was captured, and the queue wait span is
+// only recorded by the first of them to run.
+//
+// Sharing the active span doesn't allocate unless queue wait or run spans are
+// requested, which takes one allocation for the options and submission time.
+// Capturing a clone takes two more: one in SpanContext::Clone, and one for the
+// stand-in span. Copying a TaskContext doesn't allocate.
+class OPENTRACING_API TaskContext {
+ public:
+  explicit TaskContext(
+      const TaskContextOptions& options = TaskContextOptions{}) noexcept;
+
+  // Returns the span that's active while the task runs, unless a run span is
+  // requested, or nullptr if no span was active when the TaskContext was
+  // constructed.
+  const Span* span() const noexcept { return span_.get(); }
+
+  // Calls `f` with the captured span active.
+  template <class F, class... Args>
+  auto Run(F& f, Args&&... args)
+      -> decltype(f(std::forward<Args>(args)...)) {
+    if (span_ == nullptr) {
+      return f(std::forward<Args>(args)...);
+    }
+    std::shared_ptr<Span> run_span;
+    if (state_ != nullptr) {
+      run_span = StartRunSpan();
+    }
+    auto scope =
+        ScopeManager::Activate(run_span != nullptr ? run_span : span_);
+    return f(std::forward<Args>(args)...);
+  }
+
+ private:
+  class SharedState;
+
+  // The active span, or a stand-in for it. Shared by copies, which run with
+  // the same span.
+  std::shared_ptr<Span> span_;
+
+  // The options and submission time, if queue wait or run spans are
+  // requested.
+  std::shared_ptr<SharedState> state_;
+
+  // Records the queue wait span, if requested and not yet recorded, and
+  // returns the run span, if requested.
+  std::shared_ptr<Span> StartRunSpan() noexcept;
+};
+
+// ContextTask wraps a callable so that it runs with the span that was active
+// when the ContextTask was created, for handing work to a thread pool or
+// executor. See TaskContext.
+template <class F>
+class ContextTask {
+ public:
+  ContextTask(F&& f, const TaskContextOptions& options)
+      : context_{options}, f_(std::move(f)) {}
+
+  template <class... Args>
+  auto operator()(Args&&... args)
+      -> decltype(std::declval<F&>()(std::forward<Args>(args)...)) {
+    return context_.Run(f_, std::forward<Args>(args)...);
+  }
+
+ private:
+  TaskContext context_;
+  F f_;
+};
+
+// MakeContextTask wraps `f` in a ContextTask that captures the calling
+// thread's active span. For example:
+//
+//     std::shared_ptr<opentracing::Span> span =
+//         tracer.StartSpan("HandleRequest");
+//     auto scope = opentracing::ScopeManager::Activate(span);
+//     std::thread{opentracing::MakeContextTask([] {
+//       auto child = tracer.StartSpan("Work",
+//                                     {opentracing::ChildOfActiveSpan{}});
+//     })}.detach();
+template <class F>
+ContextTask<typename std::decay<F>::type> MakeContextTask(
+    F&& f, const TaskContextOptions& options = TaskContextOptions{}) {
+  return ContextTask<typename std::decay<F>::type>{
+      typename std::decay<F>::type(std::forward<F>(f)), options};
+}
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_TASK_CONTEXT_H
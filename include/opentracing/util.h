@@ -2,6 +2,7 @@
 #define OPENTRACING_UTIL_H
 
 #include <opentracing/string_view.h>
+#include <opentracing/symbols.h>
 #include <opentracing/version.h>
 #include <chrono>
 #include <system_error>
@@ -37,20 +38,67 @@ class option_wrapper {
   const T *ptr_;
 };
 
-// Support conversion between time_points from different clocks. There's no
-// standard way to get the difference in epochs between clocks, so this uses
-// an approximation suggested by Howard Hinnant.
+// Returns the system clock's time minus the steady clock's time at the same
+// instant, from a process-wide measurement. The measurement is refreshed
+// first if it's more than a second old, which is checked against a coarse
+// clock where the platform has one; this makes a conversion cost an addition
+// and a coarse clock read, and gives every conversion between two refreshes
+// the same offset.
+OPENTRACING_API std::chrono::nanoseconds GetClockOffset() noexcept;
+
+// Measures the offset returned by GetClockOffset again. Call this after the
+// system clock is adjusted to have conversions follow it right away.
+OPENTRACING_API void RefreshClockOffset() noexcept;
+
+// clock_converter converts time_points between clocks for convert_time_point.
+//
+// There's no standard way to get the difference in epochs between clocks, so
+// clocks other than the system and steady clocks use an approximation
+// suggested by Howard Hinnant, which reads both clocks on every conversion.
 //
 // See https://stackoverflow.com/a/35282833/4447365
+template <class ToClock, class FromClock>
+struct clock_converter {
+  template <class Duration>
+  static typename ToClock::time_point convert(
+      std::chrono::time_point<FromClock, Duration> from_time_point) {
+    auto from_now = FromClock::now();
+    auto to_now = ToClock::now();
+    return to_now + std::chrono::duration_cast<typename ToClock::duration>(
+                        from_time_point - from_now);
+  }
+};
+
+template <>
+struct clock_converter<SystemClock, SteadyClock> {
+  template <class Duration>
+  static SystemTime convert(
+      std::chrono::time_point<SteadyClock, Duration> from_time_point) {
+    auto offset = GetClockOffset();
+    return SystemTime{std::chrono::duration_cast<SystemClock::duration>(
+        from_time_point.time_since_epoch() + offset)};
+  }
+};
+
+template <>
+struct clock_converter<SteadyClock, SystemClock> {
+  template <class Duration>
+  static SteadyTime convert(
+      std::chrono::time_point<SystemClock, Duration> from_time_point) {
+    auto offset = GetClockOffset();
+    return SteadyTime{std::chrono::duration_cast<SteadyClock::duration>(
+        from_time_point.time_since_epoch() - offset)};
+  }
+};
+
+// Support conversion between time_points from different clocks. Conversions
+// between the system and steady clocks use the offset from GetClockOffset.
 template <class ToClock, class FromClock, class Duration,
           typename std::enable_if<
               !std::is_same<FromClock, ToClock>::value>::type * = nullptr>
 typename ToClock::time_point convert_time_point(
     std::chrono::time_point<FromClock, Duration> from_time_point) {
-  auto from_now = FromClock::now();
-  auto to_now = ToClock::now();
-  return to_now + std::chrono::duration_cast<typename ToClock::duration>(
-                      from_time_point - from_now);
+  return clock_converter<ToClock, FromClock>::convert(from_time_point);
 }
 
 template <class ToClock, class FromClock, class Duration,
@@ -0,0 +1,100 @@
+#ifndef OPENTRACING_MOCKTRACER_ADAPTIVE_SAMPLER_H
+#define OPENTRACING_MOCKTRACER_ADAPTIVE_SAMPLER_H
+
+#include <opentracing/mocktracer/sampler.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+struct AdaptiveSamplerOptions {
+  // The number of traces per second to sample across all operations.
+  double target_traces_per_second = 100;
+
+  // The probability with which operations are sampled until their rate has
+  // been measured.
+  double initial_probability = 1.0;
+
+  // No operation is sampled with a lower probability than this.
+  double min_probability = 0.0001;
+
+  // The maximum number of operations tracked separately. Traces of further
+  // operations share a single rate and probability.
+  size_t max_operations = 256;
+
+  // The number of copies of each counter, which threads starting traces are
+  // spread across so that they don't contend for the same cache lines.
+  size_t num_counter_shards = 8;
+
+  // How often probabilities are recomputed from the rates observed since the
+  // last time. If zero, they're only recomputed when Retune is called.
+  SteadyClock::duration retune_period = std::chrono::seconds{1};
+};
+
+// AdaptiveSampler samples traces with a probability chosen per operation name
+// of their root span, so that the sampled traces add up to a target rate while
+// rarely started operations are still sampled.
+//
+// Each retune period, the target is divided between the operations started
+// since the last retune. Operations started less often than their share are
+// sampled with probability 1, and what they leave unused is divided among the
+// others, whose probability is their share over their rate.
+//
+// ShouldSample is wait-free: it hashes the operation name, finds or claims the
+// operation's slot in a fixed-size table with at most max_operations probes,
+// increments a counter and compares the trace id against the operation's
+// threshold. Like ProbabilisticSampler, the decision for a given probability
+// only depends on the trace id.
+class OPENTRACING_MOCK_TRACER_API AdaptiveSampler : public Sampler {
+ public:
+  explicit AdaptiveSampler(const AdaptiveSamplerOptions& options);
+
+  AdaptiveSampler(const AdaptiveSampler&) = delete;
+  AdaptiveSampler& operator=(const AdaptiveSampler&) = delete;
+
+  ~AdaptiveSampler() override;
+
+  bool ShouldSample(uint64_t trace_id,
+                    string_view operation_name) noexcept override;
+
+  // Recomputes the probability of each operation from the number of traces
+  // started since the last retune, which happened `elapsed` ago.
+  void Retune(SteadyClock::duration elapsed) noexcept;
+
+  // Returns the probability the given operation is currently sampled with.
+  double sampling_probability(string_view operation_name) const noexcept;
+
+ private:
+  struct Operation;
+
+  AdaptiveSamplerOptions options_;
+  uint64_t initial_threshold_;
+  uint64_t min_threshold_;
+
+  // max_operations slots followed by the one shared by further operations.
+  std::unique_ptr<Operation[]> operations_;
+
+  // The counters of shard i are counters_[i * (max_operations + 1) + slot].
+  std::unique_ptr<std::atomic<uint64_t>[]> counters_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  bool exit_ = false;
+  std::thread thread_;
+
+  size_t FindOperation(uint64_t hash) const noexcept;
+
+  size_t FindOrAddOperation(uint64_t hash) noexcept;
+
+  void Run() noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_ADAPTIVE_SAMPLER_H
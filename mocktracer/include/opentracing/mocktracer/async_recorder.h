@@ -0,0 +1,125 @@
+#ifndef OPENTRACING_MOCKTRACER_ASYNC_RECORDER_H
+#define OPENTRACING_MOCKTRACER_ASYNC_RECORDER_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+class SpanQueue;
+class SpanSpool;
+
+enum class SpoolSyncPolicy {
+  // Spooled spans are written to disk whenever the operating system gets to
+  // it.
+  Never,
+
+  // Each spool segment is synced to disk once it's full.
+  EverySegment,
+
+  // Spooled spans are synced to disk after every batch.
+  EveryBatch
+};
+
+struct AsyncRecorderOptions {
+  // The maximum number of spans that can be waiting to be forwarded. Spans
+  // recorded while the queue is full are dropped.
+  size_t max_queue_size = 4096;
+
+  // The maximum number of spans forwarded to the wrapped recorder at a time.
+  // The background thread is woken up early when this many spans are queued.
+  size_t max_batch_size = 256;
+
+  // How long the background thread waits for a full batch before forwarding
+  // whatever spans are queued.
+  SteadyClock::duration flush_interval = std::chrono::milliseconds{100};
+
+  // If not empty, spans are spooled to files in this directory, rather than
+  // dropped, while the wrapped recorder can't keep up. The directory is
+  // created if it doesn't exist.
+  std::string spool_directory;
+
+  // Spooling starts once more than this many spans are queued. It should
+  // leave room in the queue for the spans recorded while a batch is being
+  // forwarded.
+  size_t spool_high_water_mark = 1024;
+
+  // The size at which a spool segment file is closed and a new one started.
+  // Segments are deleted once they've been forwarded.
+  size_t max_spool_segment_size = 16 * 1024 * 1024;
+
+  // Spans are dropped once the spool files take up this much space.
+  size_t max_spool_size = 1024 * 1024 * 1024;
+
+  SpoolSyncPolicy spool_sync_policy = SpoolSyncPolicy::EverySegment;
+};
+
+// AsyncRecorder moves the work of another recorder off of the threads that
+// finish spans.
+//
+// RecordSpan pushes the span into a bounded lock-free queue and a background
+// thread forwards queued spans in batches to the wrapped recorder. Close
+// forwards any spans still queued and then closes the wrapped recorder; spans
+// recorded once Close has started are dropped. Later calls to Close wait for
+// the first to finish.
+//
+// With a spool directory, the background thread moves queued spans to
+// segment files on disk whenever the queue grows past the high-water mark,
+// and forwards spans from the spool, oldest first, until it has caught up.
+// Spans are forwarded in the order they were recorded either way. Spooled
+// spans left behind by a process that didn't close its recorder are
+// forwarded when the next AsyncRecorder using the directory starts, so a
+// span may be forwarded more than once but isn't lost.
+class OPENTRACING_MOCK_TRACER_API AsyncRecorder : public Recorder {
+ public:
+  AsyncRecorder(std::unique_ptr<Recorder>&& recorder,
+                const AsyncRecorderOptions& options);
+
+  AsyncRecorder(const AsyncRecorder&) = delete;
+  AsyncRecorder& operator=(const AsyncRecorder&) = delete;
+
+  ~AsyncRecorder() override;
+
+  void RecordSpan(SpanData&& span_data) noexcept override;
+
+  void Close() noexcept override;
+
+  // Returns the number of spans dropped because the queue or spool was full,
+  // or because they were recorded after Close was called.
+  size_t num_dropped_spans() const noexcept {
+    return num_dropped_spans_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::unique_ptr<Recorder> recorder_;
+  AsyncRecorderOptions options_;
+  std::unique_ptr<SpanQueue> queue_;
+  std::unique_ptr<SpanSpool> spool_;
+  std::atomic<size_t> num_dropped_spans_{0};
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_condition_;
+  std::condition_variable closed_condition_;
+  bool is_closing_ = false;
+  bool is_closed_ = false;
+  std::thread thread_;
+
+  void Run() noexcept;
+
+  // Returns true if there may be more spans to forward right away.
+  bool ForwardBatch() noexcept;
+
+  bool SpoolBatch() noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_ASYNC_RECORDER_H
@@ -0,0 +1,62 @@
+#ifndef OPENTRACING_MOCKTRACER_BINARY_H
+#define OPENTRACING_MOCKTRACER_BINARY_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+class SpanDecoder;
+
+// Serialize provided spans to the compact binary format.
+//
+// The format is a header followed by a length-prefixed record per span, with
+// integers varint encoded, timestamps delta encoded, and operation names and
+// tag keys stored once per stream and afterwards referred to by index. It
+// preserves everything in SpanData except that string values are always read
+// back as std::string.
+//
+// See also BinaryRecorder and BinaryReader.
+OPENTRACING_MOCK_TRACER_API void ToBinary(std::ostream& writer,
+                                          const std::vector<SpanData>& spans);
+
+// BinaryReader reads spans back from a stream in the binary format one at a
+// time.
+class OPENTRACING_MOCK_TRACER_API BinaryReader {
+ public:
+  explicit BinaryReader(std::istream& in);
+
+  BinaryReader(const BinaryReader&) = delete;
+  BinaryReader& operator=(const BinaryReader&) = delete;
+
+  ~BinaryReader();
+
+  // Reads the next span into span_data. Returns false at the end of the
+  // stream.
+  //
+  // Throws std::runtime_error if the stream isn't in the binary format or is
+  // truncated or corrupt.
+  bool Read(SpanData& span_data);
+
+ private:
+  std::istream& in_;
+  std::unique_ptr<SpanDecoder> decoder_;
+  std::string record_;
+  bool has_read_header_ = false;
+};
+
+// Converts spans in the binary format to the JSON format written by ToJson.
+//
+// Throws std::runtime_error if the input is malformed.
+OPENTRACING_MOCK_TRACER_API void BinaryToJson(std::istream& in,
+                                              std::ostream& out);
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_BINARY_H
@@ -0,0 +1,46 @@
+#ifndef OPENTRACING_MOCKTRACER_BINARY_RECORDER_H
+#define OPENTRACING_MOCKTRACER_BINARY_RECORDER_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+class SpanEncoder;
+
+// BinaryRecorder serializes finished spans to a provided std::ostream in the
+// binary format written by ToBinary.
+//
+// Spans are encoded as they're recorded and written to the stream in chunks,
+// so memory use stays bounded. Close writes any remaining spans.
+//
+// See also BinaryReader.
+class OPENTRACING_MOCK_TRACER_API BinaryRecorder : public Recorder {
+ public:
+  explicit BinaryRecorder(std::unique_ptr<std::ostream>&& out);
+
+  BinaryRecorder(const BinaryRecorder&) = delete;
+  BinaryRecorder& operator=(const BinaryRecorder&) = delete;
+
+  ~BinaryRecorder() override;
+
+  void RecordSpan(SpanData&& span_data) noexcept override;
+
+  void Close() noexcept override;
+
+ private:
+  std::mutex mutex_;
+  std::unique_ptr<std::ostream> out_;
+  std::unique_ptr<SpanEncoder> encoder_;
+  std::string buffer_;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_BINARY_RECORDER_H
@@ -0,0 +1,57 @@
+#ifndef OPENTRACING_MOCKTRACER_CLOCK_H
+#define OPENTRACING_MOCKTRACER_CLOCK_H
+
+#include <opentracing/mocktracer/symbols.h>
+#include <opentracing/util.h>
+#include <opentracing/version.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Clock is the source of the system timestamps MockTracer gives span starts
+// and logs that aren't given explicit ones.
+//
+// Each of these reads the clock once, as a monotonic tick count, which is
+// then converted to system time by calibrated arithmetic instead of reading
+// the system clock. System times derived this way advance with the steady
+// clock from when the clock was calibrated, so they don't follow later
+// adjustments of the system clock.
+//
+// Span durations are always measured on the steady clock: Span::Finish
+// passes the span a finish time read from it, and a start time from another
+// clock would be skewed against it by the clock's calibration error. A span
+// start therefore still reads the steady clock as well as this one.
+class OPENTRACING_MOCK_TRACER_API Clock {
+ public:
+  virtual ~Clock() = default;
+
+  // Returns the current time in ticks. This may be called concurrently.
+  virtual uint64_t Now() const noexcept = 0;
+
+  virtual SystemTime ToSystemTime(uint64_t ticks) const noexcept = 0;
+};
+
+// Returns a clock that reads the CPU's time stamp counter, calibrated against
+// the steady clock by sampling both over calibration_period.
+//
+// Fails unless running on Linux on an x86 CPU whose time stamp counter runs
+// at a constant rate across frequency changes and sleep states.
+OPENTRACING_MOCK_TRACER_API expected<std::unique_ptr<Clock>> MakeTscClock(
+    std::chrono::nanoseconds calibration_period,
+    std::string& error_message) noexcept;
+
+// Returns a clock that reads CLOCK_MONOTONIC_COARSE, which is cheaper to read
+// than the steady clock but only advances every few milliseconds.
+//
+// Fails unless running on Linux.
+OPENTRACING_MOCK_TRACER_API expected<std::unique_ptr<Clock>> MakeCoarseClock(
+    std::string& error_message) noexcept;
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_CLOCK_H
@@ -0,0 +1,36 @@
+#ifndef OPENTRACING_MOCKTRACER_FILE_STREAM_H
+#define OPENTRACING_MOCKTRACER_FILE_STREAM_H
+
+#include <opentracing/mocktracer/symbols.h>
+#include <opentracing/util.h>
+#include <opentracing/version.h>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Opens a file for a recorder to write to, truncating it if it exists, such
+// that the writes to disk happen on a background thread.
+//
+// Output is collected in 64KB buffers. A full buffer, or a flush, hands the
+// buffer to the background thread, which writes every buffer handed over
+// since its last write with a single writev call once 64KB are waiting or
+// 10 milliseconds have passed. Small flushes are merged into one buffer.
+// Writing to the stream only waits on the disk if 64 buffers are already
+// waiting to be written, which keeps memory use bounded.
+//
+// Flushing or destroying the stream waits for everything written to it so
+// far to reach the file, and has the background thread write it right away.
+// A failed write puts the stream in a bad state at the next flush or full
+// buffer.
+//
+// On platforms without writev, this returns a std::ofstream.
+OPENTRACING_MOCK_TRACER_API expected<std::unique_ptr<std::ostream>>
+MakeFileStream(const std::string& path, std::string& error_message) noexcept;
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_FILE_STREAM_H
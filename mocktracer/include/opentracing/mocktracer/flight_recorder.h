@@ -0,0 +1,50 @@
+#ifndef OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_H
+#define OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+struct FlightRecorderOptions {
+  // The file to record spans into. It's created if it doesn't exist.
+  std::string path;
+
+  // The number of bytes of spans kept. This is rounded up to a multiple of
+  // 4096.
+  size_t ring_size = 16 * 1024 * 1024;
+};
+
+// Makes a recorder that writes each span into a ring buffer in a memory-mapped
+// file, so that the most recently finished spans survive a crash of the
+// process.
+//
+// Threads reserve space in the ring by atomically advancing a cursor stored in
+// the file and then copy their span into it, so recording never blocks. Each
+// record carries its position and a checksum, and ReadFlightRecording skips
+// records that were torn by a crash or overwritten by a later lap of the ring.
+// Spans larger than a quarter of the ring are dropped.
+//
+// If the file already holds a recording with the same ring size, new spans
+// are appended after it. Fails if the file is neither empty nor such a
+// recording, rather than overwrite it. A file must only be used by one
+// recorder at a time.
+//
+// Only supported on POSIX systems.
+OPENTRACING_MOCK_TRACER_API expected<std::unique_ptr<Recorder>>
+MakeFlightRecorder(const FlightRecorderOptions& options,
+                   std::string& error_message) noexcept;
+
+// Reads the spans kept in a file written by a flight recorder, oldest first.
+OPENTRACING_MOCK_TRACER_API expected<std::vector<SpanData>>
+ReadFlightRecording(const std::string& path,
+                    std::string& error_message) noexcept;
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_H
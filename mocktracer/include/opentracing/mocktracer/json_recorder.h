@@ -3,14 +3,44 @@
 
 #include <opentracing/mocktracer/recorder.h>
 #include <opentracing/mocktracer/symbols.h>
+#include <atomic>
+#include <condition_variable>
 #include <iosfwd>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
+class JsonWriter;
+
+struct JsonRecorderOptions {
+  // If true, spans are written to the stream as they're recorded instead of
+  // being buffered until Close, so that memory use stays bounded and spans
+  // reach the stream even if the process never calls Close. The output is
+  // the same JSON array in either mode; its closing bracket is written by
+  // Close.
+  //
+  // Spans are written by a background thread, so that recording never waits
+  // on serialization or the stream. They aren't flushed from the stream's
+  // buffer as they're written; Flush and Close flush the stream.
+  bool streaming = false;
+
+  // In streaming mode, buffered spans are written once this many have been
+  // recorded.
+  size_t max_buffered_spans = 100;
+
+  // In streaming mode, buffered spans are also written once the oldest has
+  // waited this long.
+  SteadyClock::duration flush_interval = std::chrono::seconds{1};
+
+  // In streaming mode, spans are dropped while the spans waiting to be
+  // written take up roughly this many bytes.
+  size_t max_buffered_bytes = 16 * 1024 * 1024;
+};
+
 // JsonRecorder serializes finished spans to a provided std::ostream in a JSON
 // format.
 //
@@ -19,14 +49,72 @@ class OPENTRACING_MOCK_TRACER_API JsonRecorder : public Recorder {
  public:
   explicit JsonRecorder(std::unique_ptr<std::ostream>&& out);
 
+  JsonRecorder(std::unique_ptr<std::ostream>&& out,
+               const JsonRecorderOptions& options);
+
+  JsonRecorder(const JsonRecorder&) = delete;
+  JsonRecorder& operator=(const JsonRecorder&) = delete;
+
+  ~JsonRecorder() override;
+
   void RecordSpan(SpanData&& span_data) noexcept override;
 
+  // Writes the spans recorded so far to the stream as the next elements of
+  // the JSON array, and flushes the stream.
+  //
+  // The buffered spans are swapped out under the lock, so concurrent calls to
+  // RecordSpan only wait for the swap and never for serialization. If the
+  // deadline passes before all of the spans are written, the remaining spans
+  // are kept for the next flush.
+  //
+  // Returns true if all of the spans were written.
+  bool Flush(SteadyTime deadline = SteadyTime::max()) noexcept;
+
   void Close() noexcept override;
 
+  // Returns the number of spans dropped in streaming mode because
+  // max_buffered_bytes were waiting to be written.
+  size_t num_dropped_spans() const noexcept {
+    return num_dropped_spans_.load(std::memory_order_relaxed);
+  }
+
  private:
+  // mutex_ protects spans_ and the state shared with the writer thread.
   std::mutex mutex_;
-  std::unique_ptr<std::ostream> out_;
+  std::condition_variable writer_condition_;
   std::vector<SpanData> spans_;
+  SteadyTime first_buffered_timestamp_;
+  size_t spans_size_ = 0;
+  size_t buffered_size_ = 0;
+  bool is_closing_ = false;
+  std::atomic<size_t> num_dropped_spans_{0};
+
+  // write_mutex_ serializes writes to out_ and protects the state used while
+  // writing.
+  std::mutex write_mutex_;
+  std::unique_ptr<std::ostream> out_;
+  std::vector<SpanData> write_buffer_;
+  size_t write_buffer_size_ = 0;
+  size_t write_index_ = 0;
+  size_t num_written_spans_ = 0;
+
+  JsonRecorderOptions options_;
+  std::thread thread_;
+
+  // Writes the buffered spans in streaming mode.
+  void Run() noexcept;
+
+  bool IsWriteReady() const noexcept {
+    return is_closing_ || spans_.size() >= options_.max_buffered_spans;
+  }
+
+  void StopWriter() noexcept;
+
+  void ClearWriteBuffer() noexcept;
+
+  bool WriteBufferedSpans(SteadyTime deadline, bool flush_stream) noexcept;
+
+  bool WriteSpans(JsonWriter& json_writer, SteadyTime deadline);
 };
 }  // namespace mocktracer
 END_OPENTRACING_ABI_NAMESPACE
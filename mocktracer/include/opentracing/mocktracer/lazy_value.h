@@ -0,0 +1,76 @@
+#ifndef OPENTRACING_MOCKTRACER_LAZY_VALUE_H
+#define OPENTRACING_MOCKTRACER_LAZY_VALUE_H
+
+#include <opentracing/mocktracer/symbols.h>
+#include <opentracing/span.h>
+#include <opentracing/string_view.h>
+#include <opentracing/value.h>
+#include <opentracing/version.h>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// LazyValue wraps a function that computes a tag or log value, so that the
+// value is only computed if a recorder encodes the span:
+//
+//    SetLazyTag(*span, "request", LazyValue{[request] {
+//                 return Value{FormatRequest(request)};
+//               }});
+//
+// The function may be called on another thread after the span has finished,
+// so it should capture what it needs by value. Copies of a LazyValue share
+// the same function.
+class LazyValue {
+ public:
+  LazyValue() noexcept = default;
+
+  template <class F>
+  explicit LazyValue(F f)
+      : function_{std::make_shared<const std::function<Value()>>(
+            std::move(f))} {}
+
+  // Calls the function. Returns a null value if there's none.
+  Value operator()() const {
+    if (function_ == nullptr) {
+      return {};
+    }
+    return (*function_)();
+  }
+
+ private:
+  std::shared_ptr<const std::function<Value()>> function_;
+};
+
+// Lazy values are equal if they compute equal values, so comparing them calls
+// both functions.
+inline bool operator==(const LazyValue& lhs, const LazyValue& rhs) {
+  return lhs() == rhs();
+}
+
+inline bool operator!=(const LazyValue& lhs, const LazyValue& rhs) {
+  return !(lhs == rhs);
+}
+
+// Sets a tag on a span started by MockTracer whose value is computed when a
+// recorder encodes the span, and never if the span is dropped. Setting a tag
+// with the same key afterwards replaces it.
+//
+// Other tracers don't support lazy values, so for their spans the value is
+// computed now and set as a regular tag if the span is recording.
+OPENTRACING_MOCK_TRACER_API void SetLazyTag(Span& span, string_view key,
+                                            const LazyValue& value) noexcept;
+
+// Logs a record whose fields are computed when a recorder encodes the span,
+// in the same way as SetLazyTag.
+OPENTRACING_MOCK_TRACER_API void LogLazy(
+    Span& span,
+    std::initializer_list<std::pair<string_view, LazyValue>> fields) noexcept;
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_LAZY_VALUE_H
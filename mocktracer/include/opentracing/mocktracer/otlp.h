@@ -0,0 +1,44 @@
+#ifndef OPENTRACING_MOCKTRACER_OTLP_H
+#define OPENTRACING_MOCKTRACER_OTLP_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+struct OtlpOptions {
+  // If not empty, set as the service.name attribute of the resource.
+  std::string service_name;
+
+  // OtlpRecorder writes out its buffered spans once this many are recorded.
+  size_t max_buffered_spans = 256;
+};
+
+// Serialize provided spans to the OpenTelemetry protocol (OTLP) protobuf
+// encoding of opentelemetry.proto.trace.v1.TracesData, which has the same
+// wire format as an ExportTraceServiceRequest.
+//
+// Spans are mapped to OTLP the same way as by OpenTelemetry's OpenTracing
+// shim:
+//   - The 64-bit trace id is written as the low half of the 128-bit OTLP trace
+//     id, so that both have the same hexadecimal representation.
+//   - The first CHILD_OF reference in the same trace becomes the parent span
+//     id; other references become links with an opentracing.ref_type
+//     attribute.
+//   - The span.kind tag becomes the span kind and a boolean error tag becomes
+//     the status. Other tags become attributes.
+//   - Logs become events named after their "event" field, or "log" if there
+//     is none, with the other fields as attributes.
+// Baggage has no OTLP equivalent and is not written.
+OPENTRACING_MOCK_TRACER_API void ToOtlp(std::ostream& writer,
+                                        const std::vector<SpanData>& spans,
+                                        const OtlpOptions& options = {});
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_OTLP_H
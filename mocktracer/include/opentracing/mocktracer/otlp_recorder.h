@@ -0,0 +1,46 @@
+#ifndef OPENTRACING_MOCKTRACER_OTLP_RECORDER_H
+#define OPENTRACING_MOCKTRACER_OTLP_RECORDER_H
+
+#include <opentracing/mocktracer/otlp.h>
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// OtlpRecorder serializes finished spans to a provided std::ostream in the
+// OTLP protobuf encoding written by ToOtlp.
+//
+// Spans are encoded as they're recorded. Every max_buffered_spans spans, and
+// on Close, the encoded spans are written out as one ResourceSpans element of
+// TracesData. Since protobuf parsers concatenate repeated fields, the whole
+// stream decodes as a single TracesData message.
+class OPENTRACING_MOCK_TRACER_API OtlpRecorder : public Recorder {
+ public:
+  explicit OtlpRecorder(std::unique_ptr<std::ostream>&& out);
+
+  OtlpRecorder(std::unique_ptr<std::ostream>&& out,
+               const OtlpOptions& options);
+
+  void RecordSpan(SpanData&& span_data) noexcept override;
+
+  void Close() noexcept override;
+
+ private:
+  std::mutex mutex_;
+  std::unique_ptr<std::ostream> out_;
+  OtlpOptions options_;
+  std::string spans_;
+  size_t num_buffered_spans_ = 0;
+
+  void WriteSpans();
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_OTLP_RECORDER_H
@@ -1,12 +1,17 @@
 #ifndef OPENTRACING_MOCKTRACER_RECORDER_H
 #define OPENTRACING_MOCKTRACER_RECORDER_H
 
+#include <opentracing/mocktracer/lazy_value.h>
 #include <opentracing/mocktracer/symbols.h>
+#include <opentracing/mocktracer/tag_map.h>
 #include <opentracing/tracer.h>
 
 #include <cstdint>
 #include <iosfwd>
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
@@ -26,8 +31,9 @@ inline bool operator!=(const SpanContextData& lhs, const SpanContextData& rhs) {
   return !(lhs == rhs);
 }
 
-std::ostream& operator<<(std::ostream& out,
-                         const SpanContextData& span_context_data);
+// Writes span_context_data as JSON.
+OPENTRACING_MOCK_TRACER_API std::ostream& operator<<(
+    std::ostream& out, const SpanContextData& span_context_data);
 
 struct SpanReferenceData {
   SpanReferenceType reference_type;
@@ -46,14 +52,41 @@ inline bool operator!=(const SpanReferenceData& lhs,
   return !(lhs == rhs);
 }
 
+// A log field whose value is computed when the span is encoded.
+struct LazyLogField {
+  // The index in SpanData::logs of the record the field belongs to.
+  size_t log_index;
+  std::string key;
+  LazyValue value;
+};
+
+inline bool operator==(const LazyLogField& lhs, const LazyLogField& rhs) {
+  return lhs.log_index == rhs.log_index && lhs.key == rhs.key &&
+         lhs.value == rhs.value;
+}
+
+inline bool operator!=(const LazyLogField& lhs, const LazyLogField& rhs) {
+  return !(lhs == rhs);
+}
+
 struct SpanData {
   SpanContextData span_context;
   std::vector<SpanReferenceData> references;
   std::string operation_name;
   SystemTime start_timestamp;
   SteadyClock::duration duration;
-  std::map<std::string, Value> tags;
+  TagMap tags;
   std::vector<LogRecord> logs;
+
+  // True if the span is a child of a context extracted from another process
+  // and of no span in this one, which makes it the root of its trace in this
+  // process. This isn't encoded by ToJson or the binary and OTLP formats.
+  bool has_remote_parent = false;
+
+  // The tags and log fields set by SetLazyTag and LogLazy, whose values
+  // haven't been computed yet.
+  std::vector<std::pair<std::string, LazyValue>> lazy_tags;
+  std::vector<LazyLogField> lazy_log_fields;
 };
 
 inline bool operator==(const SpanData& lhs, const SpanData& rhs) {
@@ -62,14 +95,29 @@ inline bool operator==(const SpanData& lhs, const SpanData& rhs) {
          lhs.operation_name == rhs.operation_name &&
          lhs.start_timestamp == rhs.start_timestamp &&
          lhs.duration == rhs.duration && lhs.tags == rhs.tags &&
-         lhs.logs == rhs.logs;
+         lhs.logs == rhs.logs &&
+         lhs.has_remote_parent == rhs.has_remote_parent &&
+         lhs.lazy_tags == rhs.lazy_tags &&
+         lhs.lazy_log_fields == rhs.lazy_log_fields;
 }
 
 inline bool operator!=(const SpanData& lhs, const SpanData& rhs) {
   return !(lhs == rhs);
 }
 
-std::ostream& operator<<(std::ostream& out, const SpanData& span_data);
+inline bool HasLazyValues(const SpanData& span_data) noexcept {
+  return !span_data.lazy_tags.empty() || !span_data.lazy_log_fields.empty();
+}
+
+// Computes span_data's lazy tags and log fields and moves them into its tags
+// and logs. The JSON, binary and OTLP encoders resolve a copy of the spans
+// they're given, so recorders only need to call this to read the values
+// themselves.
+OPENTRACING_MOCK_TRACER_API void ResolveLazyValues(SpanData& span_data);
+
+// Writes span_data as JSON in the format used by ToJson.
+OPENTRACING_MOCK_TRACER_API std::ostream& operator<<(
+    std::ostream& out, const SpanData& span_data);
 
 class OPENTRACING_MOCK_TRACER_API Recorder {
  public:
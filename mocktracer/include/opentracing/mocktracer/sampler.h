@@ -0,0 +1,90 @@
+#ifndef OPENTRACING_MOCKTRACER_SAMPLER_H
+#define OPENTRACING_MOCKTRACER_SAMPLER_H
+
+#include <opentracing/mocktracer/symbols.h>
+#include <opentracing/string_view.h>
+#include <opentracing/util.h>
+#include <opentracing/version.h>
+#include <cstdint>
+#include <mutex>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Sampler decides which traces MockTracer records.
+//
+// The decision is made once per trace, when its root span starts, and
+// inherited by every span started from a context in the trace. A span
+// continuing a trace from an extracted context asks the sampler again, since
+// the decision isn't propagated.
+//
+// A span started with a sampling.priority tag (see ext::sampling_priority)
+// overrides both: a positive priority samples it and the spans started from
+// it, zero drops them. Setting the tag after the span has started has no
+// effect on sampling.
+//
+// Spans of traces that aren't sampled don't store their operation name, tags,
+// logs or baggage, and aren't passed to the recorder.
+class OPENTRACING_MOCK_TRACER_API Sampler {
+ public:
+  virtual ~Sampler() = default;
+
+  // Returns true if the trace with the given id, whose root span has the given
+  // operation name, should be recorded. This may be called concurrently.
+  virtual bool ShouldSample(uint64_t trace_id,
+                            string_view operation_name) noexcept = 0;
+};
+
+// ConstSampler samples either every trace or none.
+class OPENTRACING_MOCK_TRACER_API ConstSampler : public Sampler {
+ public:
+  explicit ConstSampler(bool decision) noexcept : decision_{decision} {}
+
+  bool ShouldSample(uint64_t /*trace_id*/,
+                    string_view /*operation_name*/) noexcept override {
+    return decision_;
+  }
+
+ private:
+  bool decision_;
+};
+
+// ProbabilisticSampler samples traces with the given probability.
+//
+// The decision only depends on the trace id, so every process using the same
+// probability keeps or drops the same traces.
+class OPENTRACING_MOCK_TRACER_API ProbabilisticSampler : public Sampler {
+ public:
+  explicit ProbabilisticSampler(double probability) noexcept;
+
+  bool ShouldSample(uint64_t trace_id,
+                    string_view operation_name) noexcept override;
+
+ private:
+  // Traces with ids below the threshold are sampled, unless sample_all_ is
+  // set.
+  uint64_t threshold_;
+  bool sample_all_;
+};
+
+// RateLimitingSampler samples up to max_traces_per_second traces per second,
+// allowing bursts of up to a second's worth.
+class OPENTRACING_MOCK_TRACER_API RateLimitingSampler : public Sampler {
+ public:
+  explicit RateLimitingSampler(double max_traces_per_second) noexcept;
+
+  bool ShouldSample(uint64_t trace_id,
+                    string_view operation_name) noexcept override;
+
+ private:
+  std::mutex mutex_;
+  double credits_per_second_;
+  double max_credits_;
+  double credits_;
+  SteadyTime last_timestamp_;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_SAMPLER_H
@@ -0,0 +1,167 @@
+#ifndef OPENTRACING_MOCKTRACER_TAG_MAP_H
+#define OPENTRACING_MOCKTRACER_TAG_MAP_H
+
+#include <opentracing/mocktracer/symbols.h>
+#include <opentracing/string_view.h>
+#include <opentracing/value.h>
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// TagMap stores a span's tags as a vector of key-value pairs in the order they
+// were first set, along with a vector of their indices sorted by key.
+//
+// Spans usually carry only a handful of tags, so two flat vectors need far
+// fewer allocations than a node-based map. Setting a new tag appends it and
+// only shifts indices, since moving a Value is comparatively expensive. Tags
+// are iterated in the same order as they would be by a
+// std::map<std::string, Value>, and setting a tag that already exists
+// overwrites its value.
+class OPENTRACING_MOCK_TRACER_API TagMap {
+ public:
+  using value_type = std::pair<std::string, Value>;
+
+  // Iterator visits the tags in key order.
+  template <class T>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::remove_const<T>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    Iterator() noexcept = default;
+
+    Iterator(T* tags, const uint32_t* position) noexcept
+        : tags_{tags}, position_{position} {}
+
+    // Allows converting an iterator to a const_iterator.
+    template <class U, typename std::enable_if<std::is_convertible<
+                           U*, T*>::value>::type* = nullptr>
+    Iterator(const Iterator<U>& other) noexcept
+        : tags_{other.tags()}, position_{other.position()} {}
+
+    T& operator*() const noexcept { return tags_[*position_]; }
+
+    T* operator->() const noexcept { return &tags_[*position_]; }
+
+    Iterator& operator++() noexcept {
+      ++position_;
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      auto result = *this;
+      ++position_;
+      return result;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+      return lhs.position_ == rhs.position_;
+    }
+
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+      return lhs.position_ != rhs.position_;
+    }
+
+    T* tags() const noexcept { return tags_; }
+
+    const uint32_t* position() const noexcept { return position_; }
+
+   private:
+    T* tags_ = nullptr;
+    const uint32_t* position_ = nullptr;
+  };
+
+  using iterator = Iterator<value_type>;
+  using const_iterator = Iterator<const value_type>;
+
+  TagMap() = default;
+
+  // If a key is repeated, the last value given for it is kept.
+  TagMap(std::initializer_list<value_type> tags);
+
+  bool empty() const noexcept { return tags_.empty(); }
+
+  size_t size() const noexcept { return tags_.size(); }
+
+  void reserve(size_t size);
+
+  void clear() noexcept {
+    tags_.clear();
+    order_.clear();
+  }
+
+  iterator begin() noexcept { return {tags_.data(), order_.data()}; }
+  iterator end() noexcept {
+    return {tags_.data(), order_.data() + order_.size()};
+  }
+
+  const_iterator begin() const noexcept {
+    return {tags_.data(), order_.data()};
+  }
+  const_iterator end() const noexcept {
+    return {tags_.data(), order_.data() + order_.size()};
+  }
+
+  // Returns an iterator to the tag with the given key or end() if there's no
+  // such tag.
+  iterator find(string_view key) noexcept;
+  const_iterator find(string_view key) const noexcept;
+
+  size_t count(string_view key) const noexcept {
+    return find(key) == end() ? 0 : 1;
+  }
+
+  // Returns the value of the tag with the given key. Throws std::out_of_range
+  // if there's no such tag.
+  const Value& at(string_view key) const;
+
+  // Returns the value of the tag with the given key, inserting a null value if
+  // there's no such tag.
+  Value& operator[](string_view key);
+
+  // Sets the tag with the given key, overwriting any existing value.
+  void insert_or_assign(string_view key, const Value& value);
+  void insert_or_assign(string_view key, Value&& value);
+
+  friend bool operator==(const TagMap& lhs, const TagMap& rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+ private:
+  void Reallocate(size_t capacity);
+
+  // Adds a tag whose index goes at `position` in order_.
+  Value& Insert(size_t position, string_view key, Value&& value);
+
+  // Returns the position of the tag's index in order_, or nullptr if there's
+  // no tag with the given key.
+  const uint32_t* Find(string_view key) const noexcept;
+
+  // Returns the position in order_ of the first tag whose key isn't less
+  // than `key`.
+  size_t LowerBound(string_view key) const noexcept;
+
+  std::vector<value_type> tags_;
+  std::vector<uint32_t> order_;
+};
+
+inline bool operator!=(const TagMap& lhs, const TagMap& rhs) {
+  return !(lhs == rhs);
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_TAG_MAP_H
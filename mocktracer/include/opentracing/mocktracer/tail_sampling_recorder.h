@@ -0,0 +1,129 @@
+#ifndef OPENTRACING_MOCKTRACER_TAIL_SAMPLING_RECORDER_H
+#define OPENTRACING_MOCKTRACER_TAIL_SAMPLING_RECORDER_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/symbols.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+struct TailSamplingOptions {
+  // Traces with a span that took at least this long are kept. Zero disables
+  // the check.
+  SteadyClock::duration latency_threshold = SteadyClock::duration::zero();
+
+  // If true, traces with a span whose error tag is true are kept.
+  bool keep_errors = true;
+
+  // Traces with a span whose operation name is in this list are kept.
+  std::vector<std::string> operation_names;
+
+  // If set, traces for which this returns true are also kept.
+  std::function<bool(const std::vector<SpanData>& spans)> keep_trace;
+
+  // A trace whose local root hasn't finished is decided this long after its
+  // first span was recorded.
+  SteadyClock::duration decision_timeout = std::chrono::seconds{30};
+
+  // The maximum number of spans buffered across all traces. Once a shard
+  // holds its share of this, its oldest traces are decided early with the
+  // spans buffered so far.
+  size_t max_buffered_spans = 100000;
+
+  // The number of decided traces whose decision is remembered, spread over
+  // the shards, so that spans recorded after their trace was decided are kept
+  // or dropped with it. Older decisions are forgotten as new traces are
+  // decided.
+  size_t num_remembered_decisions = 16384;
+
+  // How often a background thread decides the traces that timed out, so that
+  // they're forwarded even when no more spans are recorded. Zero disables the
+  // thread, leaving timeouts to be checked only when spans are recorded.
+  SteadyClock::duration timeout_check_interval = std::chrono::seconds{1};
+
+  // The number of independently locked partitions of the buffered traces.
+  size_t num_shards = 16;
+};
+
+// TailSamplingRecorder buffers finished spans by trace and decides whether to
+// keep each trace once it's complete, so that traces can be chosen by what
+// happened in them, such as errors or high latency. The spans of a kept
+// trace are forwarded to the wrapped recorder; those of a dropped trace are
+// discarded.
+//
+// A trace is decided when its root span in this process finishes, which for
+// spans finishing in order is the last span of the trace in this process, or
+// after TailSamplingOptions::decision_timeout. The root is a span with no
+// child-of reference or, for a trace continued from another process, a span
+// whose parent was extracted (see SpanData::has_remote_parent). Spans
+// recorded after their trace was decided follow its decision while it's
+// remembered, and are otherwise buffered as a new trace. Timeouts are
+// checked when spans are recorded and periodically by a background thread,
+// and Close decides every trace still buffered.
+class OPENTRACING_MOCK_TRACER_API TailSamplingRecorder : public Recorder {
+ public:
+  TailSamplingRecorder(std::unique_ptr<Recorder>&& recorder,
+                       const TailSamplingOptions& options);
+
+  TailSamplingRecorder(const TailSamplingRecorder&) = delete;
+  TailSamplingRecorder& operator=(const TailSamplingRecorder&) = delete;
+
+  ~TailSamplingRecorder() override;
+
+  void RecordSpan(SpanData&& span_data) noexcept override;
+
+  void Close() noexcept override;
+
+  size_t num_kept_traces() const noexcept {
+    return num_kept_traces_.load(std::memory_order_relaxed);
+  }
+
+  size_t num_dropped_traces() const noexcept {
+    return num_dropped_traces_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Shard;
+
+  std::unique_ptr<Recorder> recorder_;
+  TailSamplingOptions options_;
+  size_t max_shard_spans_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> num_kept_traces_{0};
+  std::atomic<size_t> num_dropped_traces_{0};
+
+  std::mutex mutex_;
+  std::condition_variable thread_condition_;
+  bool is_stopping_ = false;
+  std::thread thread_;
+
+  void Run() noexcept;
+
+  void StopThread() noexcept;
+
+  bool ShouldKeep(const std::vector<SpanData>& spans) const;
+
+  // Decides whether to keep the trace and forwards its spans if it's kept.
+  // Returns the decision.
+  bool Decide(std::vector<SpanData>& spans) noexcept;
+
+  // Decides the traces taken from shard and remembers the decisions.
+  void DecideTraces(Shard& shard,
+                    std::vector<std::vector<SpanData>>& traces) noexcept;
+
+  void Forward(std::vector<SpanData>& spans) noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_TAIL_SAMPLING_RECORDER_H
@@ -1,7 +1,9 @@
 #ifndef OPENTRACING_MOCKTRACER_TRACER_H
 #define OPENTRACING_MOCKTRACER_TRACER_H
 
+#include <opentracing/mocktracer/clock.h>
 #include <opentracing/mocktracer/recorder.h>
+#include <opentracing/mocktracer/sampler.h>
 #include <opentracing/mocktracer/symbols.h>
 #include <opentracing/tracer.h>
 #include <map>
@@ -30,11 +32,43 @@ struct MockTracerOptions {
   // spans are dropped.
   std::unique_ptr<Recorder> recorder;
 
+  // Sampler decides which traces are recorded. If nullptr, every trace is.
+  std::unique_ptr<Sampler> sampler;
+
+  // Clock provides the system timestamps of span starts and logs that aren't
+  // given explicit ones. If nullptr, they're read from the system clock.
+  std::unique_ptr<Clock> clock;
+
   // PropagationOptions allows you to customize how the mocktracer's SpanContext
   // is propagated.
   PropagationOptions propagation_options;
+
+  // If non-zero, the memory of destroyed spans is kept on a per-thread free
+  // list holding up to span_pool_capacity spans and reused for new spans
+  // started on that thread. This avoids a heap allocation per span in
+  // steady-state workloads.
+  size_t span_pool_capacity = 0;
+
+  // If false, each span is assumed to be used by only one thread at a time and
+  // its tags, logs, and baggage are modified without locking.
+  bool thread_safe_spans = true;
+
+  // If false, spans refer to the tracer through a plain pointer instead of
+  // sharing ownership of it, so that starting and destroying spans doesn't
+  // update the tracer's reference count. This also allows a MockTracer that
+  // isn't owned by a std::shared_ptr to start spans.
+  //
+  // The tracer then keeps its recorder alive for its spans by counting the
+  // spans that haven't finished, on per-thread counters. Close and the
+  // tracer's destructor wait for those spans to finish, so they mustn't be
+  // called while spans are being started, or by a thread that still has to
+  // finish one of the tracer's spans. Finished spans may outlive the tracer,
+  // but must not be used other than to be destroyed.
+  bool spans_own_tracer = true;
 };
 
+class LiveSpanCounter;
+
 // MockTracer provides implements the OpenTracing Tracer API. It provides
 // convenient access to finished spans in such a way as to support testing.
 class OPENTRACING_MOCK_TRACER_API MockTracer
@@ -43,6 +77,8 @@ class OPENTRACING_MOCK_TRACER_API MockTracer
  public:
   explicit MockTracer(MockTracerOptions&& options);
 
+  ~MockTracer() override;
+
   std::unique_ptr<Span> StartSpanWithOptions(
       string_view operation_name, const StartSpanOptions& options) const
       noexcept override;
@@ -74,7 +110,13 @@ class OPENTRACING_MOCK_TRACER_API MockTracer
 
  private:
   std::unique_ptr<Recorder> recorder_;
+  std::unique_ptr<Sampler> sampler_;
+  std::unique_ptr<Clock> clock_;
   PropagationOptions propagation_options_;
+  size_t span_pool_capacity_;
+  bool thread_safe_spans_;
+  bool spans_own_tracer_;
+  std::unique_ptr<LiveSpanCounter> live_span_counter_;
   std::mutex mutex_;
   std::vector<SpanData> spans_;
 };
@@ -0,0 +1,202 @@
+#include <opentracing/mocktracer/adaptive_sampler.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "utility.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+static const uint64_t kSampleAll = std::numeric_limits<uint64_t>::max();
+static const size_t kNotFound = std::numeric_limits<size_t>::max();
+
+struct AdaptiveSampler::Operation {
+  // The hash of the operation's name, or zero if the slot is free.
+  std::atomic<uint64_t> hash{0};
+
+  // Traces with ids below the threshold are sampled, or every trace if it's
+  // kSampleAll.
+  std::atomic<uint64_t> threshold{0};
+};
+
+static uint64_t ToThreshold(double probability) noexcept {
+  if (probability <= 0.0) {
+    return 0;
+  }
+  // 2^64 times the probability, with anything that doesn't fit sampling all.
+  auto threshold = probability * 18446744073709551616.0;
+  if (threshold >= 18446744073709551616.0) {
+    return kSampleAll;
+  }
+  return static_cast<uint64_t>(threshold);
+}
+
+static double ToProbability(uint64_t threshold) noexcept {
+  if (threshold == kSampleAll) {
+    return 1.0;
+  }
+  return threshold / 18446744073709551616.0;
+}
+
+// FNV-1a, with zero reserved for free slots.
+static uint64_t HashOperationName(string_view operation_name) noexcept {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : operation_name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+AdaptiveSampler::AdaptiveSampler(const AdaptiveSamplerOptions& options)
+    : options_(options) {
+  if (options_.num_counter_shards == 0) {
+    options_.num_counter_shards = 1;
+  }
+  initial_threshold_ = ToThreshold(options_.initial_probability);
+  min_threshold_ = ToThreshold(options_.min_probability);
+  auto num_operations = options_.max_operations + 1;
+  operations_.reset(new Operation[num_operations]);
+  for (size_t i = 0; i < num_operations; ++i) {
+    operations_[i].threshold.store(initial_threshold_,
+                                   std::memory_order_relaxed);
+  }
+  auto num_counters = num_operations * options_.num_counter_shards;
+  counters_.reset(new std::atomic<uint64_t>[num_counters]);
+  for (size_t i = 0; i < num_counters; ++i) {
+    counters_[i].store(0, std::memory_order_relaxed);
+  }
+  if (options_.retune_period > SteadyClock::duration::zero()) {
+    thread_ = std::thread{&AdaptiveSampler::Run, this};
+  }
+}
+
+AdaptiveSampler::~AdaptiveSampler() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    exit_ = true;
+  }
+  condition_variable_.notify_one();
+  thread_.join();
+}
+
+bool AdaptiveSampler::ShouldSample(uint64_t trace_id,
+                                   string_view operation_name) noexcept {
+  auto slot = FindOrAddOperation(HashOperationName(operation_name));
+  auto shard = GetThreadIndex() % options_.num_counter_shards;
+  counters_[shard * (options_.max_operations + 1) + slot].fetch_add(
+      1, std::memory_order_relaxed);
+  auto threshold =
+      operations_[slot].threshold.load(std::memory_order_relaxed);
+  return threshold == kSampleAll || trace_id < threshold;
+}
+
+void AdaptiveSampler::Retune(SteadyClock::duration elapsed) noexcept try {
+  auto seconds = std::chrono::duration<double>(elapsed).count();
+  if (seconds <= 0) {
+    return;
+  }
+  auto num_operations = options_.max_operations + 1;
+  std::vector<std::pair<double, size_t>> rates;
+  for (size_t slot = 0; slot < num_operations; ++slot) {
+    uint64_t count = 0;
+    for (size_t shard = 0; shard < options_.num_counter_shards; ++shard) {
+      count += counters_[shard * num_operations + slot].exchange(
+          0, std::memory_order_relaxed);
+    }
+    if (count > 0) {
+      rates.emplace_back(count / seconds, slot);
+    }
+  }
+
+  // Give each operation an equal share of what's left of the target, from the
+  // least started up, so operations below their share pass the rest on.
+  std::sort(rates.begin(), rates.end());
+  auto budget = std::max(options_.target_traces_per_second, 0.0);
+  auto num_remaining = rates.size();
+  for (auto& rate : rates) {
+    auto share = budget / num_remaining--;
+    uint64_t threshold;
+    if (rate.first <= share) {
+      threshold = kSampleAll;
+      budget -= rate.first;
+    } else {
+      threshold = std::max(ToThreshold(share / rate.first), min_threshold_);
+      budget -= share;
+    }
+    operations_[rate.second].threshold.store(threshold,
+                                             std::memory_order_relaxed);
+  }
+} catch (const std::exception& /*e*/) {
+  // Keep the current probabilities.
+}
+
+double AdaptiveSampler::sampling_probability(string_view operation_name) const
+    noexcept {
+  auto slot = FindOperation(HashOperationName(operation_name));
+  if (slot == kNotFound) {
+    return ToProbability(initial_threshold_);
+  }
+  return ToProbability(
+      operations_[slot].threshold.load(std::memory_order_relaxed));
+}
+
+// Returns the slot of the operation with the given hash, kNotFound if it
+// hasn't been added, or the shared slot if it can't be.
+size_t AdaptiveSampler::FindOperation(uint64_t hash) const noexcept {
+  auto max_operations = options_.max_operations;
+  for (size_t i = 0; i < max_operations; ++i) {
+    auto slot = (hash + i) % max_operations;
+    auto slot_hash = operations_[slot].hash.load(std::memory_order_acquire);
+    if (slot_hash == hash) {
+      return slot;
+    }
+    if (slot_hash == 0) {
+      return kNotFound;
+    }
+  }
+  return max_operations;
+}
+
+size_t AdaptiveSampler::FindOrAddOperation(uint64_t hash) noexcept {
+  auto max_operations = options_.max_operations;
+  for (size_t i = 0; i < max_operations; ++i) {
+    auto slot = (hash + i) % max_operations;
+    auto& slot_hash = operations_[slot].hash;
+    auto expected_hash = slot_hash.load(std::memory_order_acquire);
+    if (expected_hash == 0 &&
+        slot_hash.compare_exchange_strong(expected_hash, hash,
+                                          std::memory_order_acq_rel)) {
+      return slot;
+    }
+    if (expected_hash == hash) {
+      return slot;
+    }
+  }
+  return max_operations;
+}
+
+void AdaptiveSampler::Run() noexcept {
+  auto last_timestamp = SteadyClock::now();
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    condition_variable_.wait_for(lock, options_.retune_period,
+                                 [this] { return exit_; });
+    if (exit_) {
+      return;
+    }
+    lock.unlock();
+    auto now = SteadyClock::now();
+    Retune(now - last_timestamp);
+    last_timestamp = now;
+    lock.lock();
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,140 @@
+#include <opentracing/mocktracer/async_recorder.h>
+#include "span_queue.h"
+#include "span_spool.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+AsyncRecorder::AsyncRecorder(std::unique_ptr<Recorder>&& recorder,
+                             const AsyncRecorderOptions& options)
+    : recorder_{std::move(recorder)},
+      options_(options),
+      queue_{new SpanQueue{options.max_queue_size}} {
+  if (options_.max_batch_size == 0) {
+    options_.max_batch_size = 1;
+  }
+  if (recorder_ != nullptr && !options_.spool_directory.empty()) {
+    spool_.reset(new SpanSpool{options_});
+  }
+  thread_ = std::thread{&AsyncRecorder::Run, this};
+}
+
+AsyncRecorder::~AsyncRecorder() { Close(); }
+
+void AsyncRecorder::RecordSpan(SpanData&& span_data) noexcept {
+  // Pushes fail once Close has closed the queue, and Close forwards every
+  // span pushed before that.
+  if (!queue_->TryPush(std::move(span_data))) {
+    num_dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Notifying without holding the mutex means the background thread can miss
+  // the wakeup, but then it still forwards the spans after flush_interval.
+  if (queue_->size() >= options_.max_batch_size) {
+    wakeup_condition_.notify_one();
+  }
+}
+
+void AsyncRecorder::Close() noexcept {
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (is_closing_) {
+      // Wait for the first call to finish forwarding.
+      closed_condition_.wait(lock, [this] { return is_closed_; });
+      return;
+    }
+    is_closing_ = true;
+  }
+  queue_->Close();
+  wakeup_condition_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  // Forward any spans queued after the background thread's last batch,
+  // including those whose pushes were still in progress when the queue
+  // closed.
+  while (true) {
+    while (ForwardBatch()) {
+    }
+    if (queue_->IsDrained()) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  if (recorder_ != nullptr) {
+    recorder_->Close();
+  }
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    is_closed_ = true;
+  }
+  closed_condition_.notify_all();
+}
+
+void AsyncRecorder::Run() noexcept {
+  while (true) {
+    if (ForwardBatch()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (is_closing_) {
+      return;
+    }
+    wakeup_condition_.wait_for(lock, options_.flush_interval, [this] {
+      return is_closing_ || queue_->size() >= options_.max_batch_size;
+    });
+  }
+}
+
+bool AsyncRecorder::ForwardBatch() noexcept {
+  if (spool_ != nullptr &&
+      (!spool_->empty() ||
+       queue_->size() > options_.spool_high_water_mark)) {
+    return SpoolBatch();
+  }
+  size_t num_forwarded = 0;
+  SpanData span_data;
+  while (num_forwarded < options_.max_batch_size &&
+         queue_->TryPop(span_data)) {
+    if (recorder_ != nullptr) {
+      recorder_->RecordSpan(std::move(span_data));
+    }
+    ++num_forwarded;
+
+    // Switch to spooling as soon as the queue passes the high-water mark.
+    if (spool_ != nullptr &&
+        queue_->size() > options_.spool_high_water_mark) {
+      return true;
+    }
+  }
+  return num_forwarded == options_.max_batch_size;
+}
+
+// Moves every queued span to the spool and then forwards a batch of the
+// oldest spooled spans, so that spans recorded while the wrapped recorder is
+// slow wait on disk rather than in the queue. Forwarding stops early if the
+// queue passes the high-water mark again.
+bool AsyncRecorder::SpoolBatch() noexcept {
+  SpanData span_data;
+  for (size_t i = 0; i < options_.max_queue_size && queue_->TryPop(span_data);
+       ++i) {
+    if (!spool_->Write(span_data)) {
+      num_dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  spool_->Flush();
+
+  size_t num_forwarded = 0;
+  while (num_forwarded < options_.max_batch_size &&
+         queue_->size() <= options_.spool_high_water_mark &&
+         spool_->Read(span_data)) {
+    recorder_->RecordSpan(std::move(span_data));
+    ++num_forwarded;
+  }
+  return !spool_->empty() || queue_->size() > 0;
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
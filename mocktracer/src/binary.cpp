@@ -0,0 +1,94 @@
+#include <opentracing/mocktracer/binary.h>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include "binary_encoding.h"
+#include "json_writer.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Encoded spans are written to the stream once they take up this much space.
+static const size_t MaxBufferSize = 64 * 1024;
+
+// Records larger than this are assumed to be corrupt rather than allocated.
+static const uint64_t MaxRecordSize = 1 << 30;
+
+void ToBinary(std::ostream& writer, const std::vector<SpanData>& spans) {
+  SpanEncoder encoder;
+  std::string buffer{BinaryHeader, sizeof(BinaryHeader)};
+  for (auto& span_data : spans) {
+    encoder.Encode(span_data, buffer);
+    if (buffer.size() >= MaxBufferSize) {
+      writer.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
+    }
+  }
+  writer.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+BinaryReader::BinaryReader(std::istream& in)
+    : in_(in), decoder_{new SpanDecoder{}} {}
+
+BinaryReader::~BinaryReader() = default;
+
+bool BinaryReader::Read(SpanData& span_data) {
+  if (!has_read_header_) {
+    char header[sizeof(BinaryHeader)];
+    in_.read(header, sizeof(header));
+    if (in_.gcount() == 0 && in_.eof()) {
+      return false;
+    }
+    if (in_.gcount() != sizeof(header) ||
+        !std::equal(header, header + sizeof(header), BinaryHeader)) {
+      throw std::runtime_error{"not a binary span stream"};
+    }
+    has_read_header_ = true;
+  }
+
+  auto c = in_.get();
+  if (c == std::istream::traits_type::eof()) {
+    return false;
+  }
+  uint64_t size = 0;
+  for (int shift = 0;; shift += 7) {
+    if (c == std::istream::traits_type::eof() || shift >= 64) {
+      throw std::runtime_error{"truncated binary span stream"};
+    }
+    size |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      break;
+    }
+    c = in_.get();
+  }
+  if (size > MaxRecordSize) {
+    throw std::runtime_error{"malformed binary span record"};
+  }
+  record_.resize(static_cast<size_t>(size));
+  in_.read(&record_[0], static_cast<std::streamsize>(size));
+  if (static_cast<uint64_t>(in_.gcount()) != size) {
+    throw std::runtime_error{"truncated binary span stream"};
+  }
+  decoder_->Decode(record_, span_data);
+  return true;
+}
+
+void BinaryToJson(std::istream& in, std::ostream& out) {
+  BinaryReader reader{in};
+  JsonWriter json_writer{out};
+  json_writer.Write('[');
+  SpanData span_data;
+  size_t num_spans = 0;
+  while (reader.Read(span_data)) {
+    if (num_spans++ != 0) {
+      json_writer.Write(',');
+    }
+    json_writer.WriteSpan(span_data);
+  }
+  json_writer.Write(']');
+  json_writer.Flush();
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
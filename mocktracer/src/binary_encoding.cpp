@@ -0,0 +1,455 @@
+#include "binary_encoding.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+const char BinaryHeader[5] = {'O', 'T', 'M', 'B', 1};
+
+// Values nested deeper than this are rejected when decoding so that a
+// malformed record can't exhaust the stack.
+static const int MaxValueDepth = 256;
+
+namespace {
+enum ValueType : uint8_t {
+  NullValue = 0,
+  FalseValue = 1,
+  TrueValue = 2,
+  DoubleValue = 3,
+  Int64Value = 4,
+  Uint64Value = 5,
+  StringValue = 6,
+  ValuesValue = 7,
+  DictionaryValue = 8
+};
+
+enum ReferenceFlags : uint8_t {
+  FollowsFromFlag = 1,
+  // Set if the referenced span is in the same trace, in which case the trace
+  // id is omitted.
+  SameTraceFlag = 2
+};
+}  // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Encoding
+//------------------------------------------------------------------------------
+static void EncodeVarint(std::string& out, uint64_t x) {
+  char bytes[10];
+  size_t size = 0;
+  while (x >= 0x80) {
+    bytes[size++] = static_cast<char>((x & 0x7f) | 0x80);
+    x >>= 7;
+  }
+  bytes[size++] = static_cast<char>(x);
+  out.append(bytes, size);
+}
+
+static void EncodeSignedVarint(std::string& out, int64_t x) {
+  auto zigzag = static_cast<uint64_t>(x) << 1;
+  EncodeVarint(out, x < 0 ? ~zigzag : zigzag);
+}
+
+static void EncodeFixed64(std::string& out, uint64_t x) {
+  char bytes[8];
+  for (auto& byte : bytes) {
+    byte = static_cast<char>(x & 0xff);
+    x >>= 8;
+  }
+  out.append(bytes, sizeof(bytes));
+}
+
+static void EncodeString(std::string& out, string_view s) {
+  EncodeVarint(out, s.size());
+  out.append(s.data(), s.size());
+}
+
+template <class Rep, class Period>
+static int64_t ToNanoseconds(const std::chrono::duration<Rep, Period>& x) {
+  return static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(x).count());
+}
+
+void SpanEncoder::EncodeDictionaryString(const std::string& s) {
+  auto iter = dictionary_.find(s);
+  if (iter != dictionary_.end()) {
+    EncodeVarint(record_, iter->second + 1);
+    return;
+  }
+  EncodeVarint(record_, 0);
+  EncodeString(record_, s);
+  if (dictionary_.size() < MaxDictionarySize) {
+    auto index = dictionary_.size();
+    dictionary_.emplace(s, index);
+  }
+}
+
+struct SpanEncoder::ValueVisitor {
+  SpanEncoder& encoder;
+
+  void operator()(bool value) {
+    encoder.record_.push_back(value ? TrueValue : FalseValue);
+  }
+
+  void operator()(double value) {
+    encoder.record_.push_back(DoubleValue);
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    EncodeFixed64(encoder.record_, bits);
+  }
+
+  void operator()(int64_t value) {
+    encoder.record_.push_back(Int64Value);
+    EncodeSignedVarint(encoder.record_, value);
+  }
+
+  void operator()(uint64_t value) {
+    encoder.record_.push_back(Uint64Value);
+    EncodeVarint(encoder.record_, value);
+  }
+
+  void operator()(const std::string& s) { (*this)(string_view{s}); }
+
+  void operator()(string_view s) {
+    encoder.record_.push_back(StringValue);
+    EncodeString(encoder.record_, s);
+  }
+
+  void operator()(std::nullptr_t) { encoder.record_.push_back(NullValue); }
+
+  void operator()(const char* s) { (*this)(string_view{s}); }
+
+  void operator()(const Values& values) {
+    encoder.record_.push_back(ValuesValue);
+    EncodeVarint(encoder.record_, values.size());
+    for (auto& value : values) {
+      encoder.EncodeValue(value);
+    }
+  }
+
+  void operator()(const Dictionary& dictionary) {
+    encoder.record_.push_back(DictionaryValue);
+    EncodeVarint(encoder.record_, dictionary.size());
+    for (auto& key_value : dictionary) {
+      EncodeString(encoder.record_, key_value.first);
+      encoder.EncodeValue(key_value.second);
+    }
+  }
+};
+
+void SpanEncoder::EncodeValue(const Value& value) {
+  ValueVisitor value_visitor{*this};
+  apply_visitor(value_visitor, value);
+}
+
+void SpanEncoder::EncodeLogRecord(const LogRecord& log_record,
+                                  int64_t start_timestamp) {
+  EncodeSignedVarint(
+      record_,
+      ToNanoseconds(log_record.timestamp.time_since_epoch()) - start_timestamp);
+  EncodeVarint(record_, log_record.fields.size());
+  for (auto& field : log_record.fields) {
+    EncodeDictionaryString(field.first);
+    EncodeValue(field.second);
+  }
+}
+
+// Encodes span_data into record_ and returns its start timestamp.
+int64_t SpanEncoder::EncodeRecord(const SpanData& span_data) {
+  if (HasLazyValues(span_data)) {
+    auto resolved = span_data;
+    ResolveLazyValues(resolved);
+    return EncodeRecord(resolved);
+  }
+  record_.clear();
+  auto& span_context = span_data.span_context;
+  EncodeFixed64(record_, span_context.trace_id);
+  EncodeFixed64(record_, span_context.span_id);
+  EncodeVarint(record_, span_context.baggage.size());
+  for (auto& baggage_item : span_context.baggage) {
+    EncodeDictionaryString(baggage_item.first);
+    EncodeString(record_, baggage_item.second);
+  }
+
+  EncodeVarint(record_, span_data.references.size());
+  for (auto& reference : span_data.references) {
+    uint8_t flags = 0;
+    if (reference.reference_type == SpanReferenceType::FollowsFromRef) {
+      flags |= FollowsFromFlag;
+    }
+    if (reference.trace_id == span_context.trace_id) {
+      flags |= SameTraceFlag;
+    }
+    record_.push_back(static_cast<char>(flags));
+    if ((flags & SameTraceFlag) == 0) {
+      EncodeFixed64(record_, reference.trace_id);
+    }
+    EncodeFixed64(record_, reference.span_id);
+  }
+
+  EncodeDictionaryString(span_data.operation_name);
+
+  auto start_timestamp =
+      ToNanoseconds(span_data.start_timestamp.time_since_epoch());
+  EncodeSignedVarint(record_, start_timestamp - last_start_timestamp_);
+  EncodeSignedVarint(record_, ToNanoseconds(span_data.duration));
+
+  EncodeVarint(record_, span_data.tags.size());
+  for (auto& tag : span_data.tags) {
+    EncodeDictionaryString(tag.first);
+    EncodeValue(tag.second);
+  }
+
+  EncodeVarint(record_, span_data.logs.size());
+  for (auto& log_record : span_data.logs) {
+    EncodeLogRecord(log_record, start_timestamp);
+  }
+
+  return start_timestamp;
+}
+
+// Forgets any strings added to the dictionary since it had dictionary_size
+// entries.
+void SpanEncoder::ShrinkDictionary(size_t dictionary_size) {
+  for (auto iter = dictionary_.begin(); iter != dictionary_.end();) {
+    if (iter->second >= dictionary_size) {
+      iter = dictionary_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void SpanEncoder::Encode(const SpanData& span_data, std::string& buffer) {
+  auto dictionary_size = dictionary_.size();
+  auto buffer_size = buffer.size();
+  try {
+    auto start_timestamp = EncodeRecord(span_data);
+    EncodeVarint(buffer, record_.size());
+    buffer.append(record_);
+    last_start_timestamp_ = start_timestamp;
+  } catch (...) {
+    // The record wasn't written, so forget any strings it added to the
+    // dictionary; otherwise the decoder's dictionary would fall out of step.
+    ShrinkDictionary(dictionary_size);
+    buffer.resize(buffer_size);
+    throw;
+  }
+}
+
+const std::string& SpanEncoder::EncodeStandalone(const SpanData& span_data) {
+  dictionary_.clear();
+  last_start_timestamp_ = 0;
+  EncodeRecord(span_data);
+  return record_;
+}
+
+//------------------------------------------------------------------------------
+// Decoding
+//------------------------------------------------------------------------------
+static void ThrowMalformed() {
+  throw std::runtime_error{"malformed binary span record"};
+}
+
+uint8_t SpanDecoder::DecodeByte() {
+  if (first_ == last_) {
+    ThrowMalformed();
+  }
+  return static_cast<uint8_t>(*first_++);
+}
+
+uint64_t SpanDecoder::DecodeVarint() {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    auto byte = DecodeByte();
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return result;
+    }
+  }
+  ThrowMalformed();
+  return 0;
+}
+
+int64_t SpanDecoder::DecodeSignedVarint() {
+  auto zigzag = DecodeVarint();
+  return static_cast<int64_t>((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+uint64_t SpanDecoder::DecodeFixed64() {
+  if (last_ - first_ < 8) {
+    ThrowMalformed();
+  }
+  uint64_t result = 0;
+  for (int i = 7; i >= 0; --i) {
+    result = (result << 8) | static_cast<uint8_t>(first_[i]);
+  }
+  first_ += 8;
+  return result;
+}
+
+void SpanDecoder::DecodeString(std::string& s) {
+  auto size = DecodeVarint();
+  if (size > static_cast<uint64_t>(last_ - first_)) {
+    ThrowMalformed();
+  }
+  s.assign(first_, static_cast<size_t>(size));
+  first_ += size;
+}
+
+const std::string& SpanDecoder::DecodeDictionaryString() {
+  auto index = DecodeVarint();
+  if (index == 0) {
+    std::string s;
+    DecodeString(s);
+    if (dictionary_.size() < MaxDictionarySize) {
+      dictionary_.emplace_back(std::move(s));
+      return dictionary_.back();
+    }
+    // The dictionary is full, so the string only lives until the next call.
+    overflow_string_ = std::move(s);
+    return overflow_string_;
+  }
+  if (index > dictionary_.size()) {
+    ThrowMalformed();
+  }
+  return dictionary_[static_cast<size_t>(index - 1)];
+}
+
+// Returns a count read from the record after checking that it isn't larger
+// than the number of remaining bytes, since every element takes at least one.
+static size_t CheckCount(uint64_t count, const char* first, const char* last) {
+  if (count > static_cast<uint64_t>(last - first)) {
+    ThrowMalformed();
+  }
+  return static_cast<size_t>(count);
+}
+
+Value SpanDecoder::DecodeValue(int depth) {
+  if (depth > MaxValueDepth) {
+    ThrowMalformed();
+  }
+  switch (DecodeByte()) {
+    case NullValue:
+      return nullptr;
+    case FalseValue:
+      return false;
+    case TrueValue:
+      return true;
+    case DoubleValue: {
+      auto bits = DecodeFixed64();
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    case Int64Value:
+      return DecodeSignedVarint();
+    case Uint64Value:
+      return DecodeVarint();
+    case StringValue: {
+      std::string s;
+      DecodeString(s);
+      return s;
+    }
+    case ValuesValue: {
+      auto num_values = CheckCount(DecodeVarint(), first_, last_);
+      Values values;
+      values.reserve(num_values);
+      for (size_t i = 0; i < num_values; ++i) {
+        values.emplace_back(DecodeValue(depth + 1));
+      }
+      return values;
+    }
+    case DictionaryValue: {
+      auto num_values = CheckCount(DecodeVarint(), first_, last_);
+      Dictionary dictionary;
+      for (size_t i = 0; i < num_values; ++i) {
+        std::string key;
+        DecodeString(key);
+        dictionary.emplace(std::move(key), DecodeValue(depth + 1));
+      }
+      return dictionary;
+    }
+  }
+  ThrowMalformed();
+  return nullptr;
+}
+
+void SpanDecoder::DecodeLogRecord(LogRecord& log_record,
+                                  int64_t start_timestamp) {
+  log_record.timestamp = SystemTime{
+      std::chrono::duration_cast<SystemClock::duration>(std::chrono::nanoseconds{
+          start_timestamp + DecodeSignedVarint()})};
+  auto num_fields = CheckCount(DecodeVarint(), first_, last_);
+  log_record.fields.clear();
+  log_record.fields.reserve(num_fields);
+  for (size_t i = 0; i < num_fields; ++i) {
+    auto& key = DecodeDictionaryString();
+    log_record.fields.emplace_back(key, DecodeValue(0));
+  }
+}
+
+void SpanDecoder::Decode(const std::string& record, SpanData& span_data) {
+  first_ = record.data();
+  last_ = first_ + record.size();
+  auto dictionary_size = dictionary_.size();
+  try {
+    auto& span_context = span_data.span_context;
+    span_context.trace_id = DecodeFixed64();
+    span_context.span_id = DecodeFixed64();
+    auto num_baggage = CheckCount(DecodeVarint(), first_, last_);
+    span_context.baggage.clear();
+    for (size_t i = 0; i < num_baggage; ++i) {
+      auto& key = DecodeDictionaryString();
+      DecodeString(span_context.baggage[key]);
+    }
+
+    auto num_references = CheckCount(DecodeVarint(), first_, last_);
+    span_data.references.resize(num_references);
+    for (auto& reference : span_data.references) {
+      auto flags = DecodeByte();
+      reference.reference_type = (flags & FollowsFromFlag) != 0
+                                     ? SpanReferenceType::FollowsFromRef
+                                     : SpanReferenceType::ChildOfRef;
+      reference.trace_id = (flags & SameTraceFlag) != 0
+                               ? span_context.trace_id
+                               : DecodeFixed64();
+      reference.span_id = DecodeFixed64();
+    }
+
+    span_data.operation_name = DecodeDictionaryString();
+
+    auto start_timestamp = last_start_timestamp_ + DecodeSignedVarint();
+    span_data.start_timestamp =
+        SystemTime{std::chrono::duration_cast<SystemClock::duration>(
+            std::chrono::nanoseconds{start_timestamp})};
+    span_data.duration = std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::nanoseconds{DecodeSignedVarint()});
+
+    auto num_tags = CheckCount(DecodeVarint(), first_, last_);
+    span_data.tags.clear();
+    span_data.tags.reserve(num_tags);
+    for (size_t i = 0; i < num_tags; ++i) {
+      auto& key = DecodeDictionaryString();
+      span_data.tags.insert_or_assign(key, DecodeValue(0));
+    }
+
+    auto num_logs = CheckCount(DecodeVarint(), first_, last_);
+    span_data.logs.resize(num_logs);
+    for (auto& log_record : span_data.logs) {
+      DecodeLogRecord(log_record, start_timestamp);
+    }
+
+    if (first_ != last_) {
+      ThrowMalformed();
+    }
+    last_start_timestamp_ = start_timestamp;
+  } catch (...) {
+    dictionary_.resize(dictionary_size);
+    throw;
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
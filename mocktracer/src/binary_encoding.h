@@ -0,0 +1,86 @@
+#ifndef OPENTRACING_MOCKTRACER_BINARY_ENCODING_H
+#define OPENTRACING_MOCKTRACER_BINARY_ENCODING_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// A stream in the binary format starts with BinaryHeader, followed by one
+// record per span. Each record is a varint byte length followed by the
+// encoded span.
+//
+// Within a record, integers are written as LEB128 varints (signed values
+// zigzag encoded first), except for trace and span ids, which are random and
+// written as 8 little-endian bytes. Timestamps and durations are in
+// nanoseconds; a span's start timestamp is stored as the difference from the
+// previous span's and log timestamps as the difference from the span's start.
+//
+// Operation names, tag keys, baggage keys and log field keys go through a
+// dictionary shared by the whole stream: the first occurrence of a string is
+// written out and assigned the next index, and later occurrences are written
+// as that index. Once the dictionary holds MaxDictionarySize strings, new
+// strings are written out without being added.
+extern const char BinaryHeader[5];
+
+const size_t MaxDictionarySize = 1 << 16;
+
+class SpanEncoder {
+ public:
+  // Appends the record for span_data to buffer.
+  void Encode(const SpanData& span_data, std::string& buffer);
+
+  // Encodes span_data as a record that can be decoded on its own, by a new
+  // SpanDecoder, and returns it without a length prefix. The result is valid
+  // until the next call.
+  //
+  // This forgets the strings and timestamp of earlier spans, so it shouldn't
+  // be mixed with calls to Encode.
+  const std::string& EncodeStandalone(const SpanData& span_data);
+
+ private:
+  std::unordered_map<std::string, uint64_t> dictionary_;
+  int64_t last_start_timestamp_ = 0;
+  std::string record_;
+
+  struct ValueVisitor;
+
+  int64_t EncodeRecord(const SpanData& span_data);
+  void ShrinkDictionary(size_t dictionary_size);
+  void EncodeDictionaryString(const std::string& s);
+  void EncodeValue(const Value& value);
+  void EncodeLogRecord(const LogRecord& log_record, int64_t start_timestamp);
+};
+
+class SpanDecoder {
+ public:
+  // Decodes a record, without its length prefix, into span_data.
+  //
+  // Throws std::runtime_error if the record is malformed.
+  void Decode(const std::string& record, SpanData& span_data);
+
+ private:
+  std::vector<std::string> dictionary_;
+  std::string overflow_string_;
+  int64_t last_start_timestamp_ = 0;
+  const char* first_ = nullptr;
+  const char* last_ = nullptr;
+
+  uint8_t DecodeByte();
+  uint64_t DecodeVarint();
+  int64_t DecodeSignedVarint();
+  uint64_t DecodeFixed64();
+  void DecodeString(std::string& s);
+  const std::string& DecodeDictionaryString();
+  Value DecodeValue(int depth);
+  void DecodeLogRecord(LogRecord& log_record, int64_t start_timestamp);
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_BINARY_ENCODING_H
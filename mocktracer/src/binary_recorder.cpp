@@ -0,0 +1,45 @@
+#include <opentracing/mocktracer/binary_recorder.h>
+#include <ostream>
+#include "binary_encoding.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Encoded spans are written to the stream once they take up this much space.
+static const size_t MaxBufferSize = 64 * 1024;
+
+BinaryRecorder::BinaryRecorder(std::unique_ptr<std::ostream>&& out)
+    : out_{std::move(out)},
+      encoder_{new SpanEncoder{}},
+      buffer_{BinaryHeader, sizeof(BinaryHeader)} {}
+
+BinaryRecorder::~BinaryRecorder() = default;
+
+void BinaryRecorder::RecordSpan(SpanData&& span_data) noexcept try {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (out_ == nullptr) {
+    return;
+  }
+  encoder_->Encode(span_data, buffer_);
+  if (buffer_.size() >= MaxBufferSize) {
+    out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+} catch (const std::exception&) {
+  // Drop span.
+}
+
+void BinaryRecorder::Close() noexcept try {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (out_ == nullptr) {
+    return;
+  }
+  out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+  out_->flush();
+} catch (const std::exception&) {
+  // Ignore errors.
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,126 @@
+#include <opentracing/mocktracer/clock.h>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifdef __linux__
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OPENTRACING_MOCKTRACER_HAS_TSC 1
+#endif
+#endif
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+namespace {
+// LinearClock converts ticks read by ReadTicks to system time by scaling
+// their distance from a calibration point.
+template <uint64_t (*ReadTicks)()>
+class LinearClock : public Clock {
+ public:
+  LinearClock(uint64_t base_ticks, SystemTime base_system_timestamp,
+              double nanoseconds_per_tick) noexcept
+      : base_ticks_{base_ticks},
+        base_system_timestamp_{base_system_timestamp},
+        nanoseconds_per_tick_{nanoseconds_per_tick} {}
+
+  uint64_t Now() const noexcept override { return ReadTicks(); }
+
+  SystemTime ToSystemTime(uint64_t ticks) const noexcept override {
+    return base_system_timestamp_ +
+           std::chrono::duration_cast<SystemClock::duration>(Elapsed(ticks));
+  }
+
+ private:
+  uint64_t base_ticks_;
+  SystemTime base_system_timestamp_;
+  double nanoseconds_per_tick_;
+
+  std::chrono::nanoseconds Elapsed(uint64_t ticks) const noexcept {
+    // Ticks before the calibration point wrap to a negative difference.
+    auto delta = static_cast<int64_t>(ticks - base_ticks_);
+    return std::chrono::nanoseconds{
+        static_cast<int64_t>(delta * nanoseconds_per_tick_)};
+  }
+};
+}  // anonymous namespace
+
+#ifdef OPENTRACING_MOCKTRACER_HAS_TSC
+static uint64_t ReadTsc() { return __rdtsc(); }
+
+// Returns true if /proc/cpuinfo reports that the time stamp counter ticks at
+// a constant rate, including while the CPU is idle.
+static bool IsTscInvariant() {
+  std::ifstream cpuinfo{"/proc/cpuinfo"};
+  std::string contents{std::istreambuf_iterator<char>{cpuinfo},
+                       std::istreambuf_iterator<char>{}};
+  return contents.find(" constant_tsc") != std::string::npos &&
+         contents.find(" nonstop_tsc") != std::string::npos;
+}
+
+expected<std::unique_ptr<Clock>> MakeTscClock(
+    std::chrono::nanoseconds calibration_period,
+    std::string& error_message) noexcept try {
+  if (!IsTscInvariant()) {
+    error_message = "the time stamp counter isn't invariant on this CPU";
+    return make_unexpected(std::make_error_code(std::errc::not_supported));
+  }
+  auto base_ticks = ReadTsc();
+  auto base_steady_timestamp = SteadyClock::now();
+  auto base_system_timestamp = SystemClock::now();
+  auto end_steady_timestamp = base_steady_timestamp;
+  uint64_t end_ticks;
+  do {
+    end_ticks = ReadTsc();
+    end_steady_timestamp = SteadyClock::now();
+  } while (end_steady_timestamp - base_steady_timestamp < calibration_period ||
+           end_ticks == base_ticks);
+  auto nanoseconds_per_tick =
+      std::chrono::duration<double, std::nano>(end_steady_timestamp -
+                                               base_steady_timestamp)
+          .count() /
+      static_cast<double>(end_ticks - base_ticks);
+  return std::unique_ptr<Clock>{new LinearClock<ReadTsc>{
+      base_ticks, base_system_timestamp, nanoseconds_per_tick}};
+} catch (const std::exception& e) {
+  error_message = e.what();
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+}
+#else
+expected<std::unique_ptr<Clock>> MakeTscClock(
+    std::chrono::nanoseconds /*calibration_period*/,
+    std::string& error_message) noexcept {
+  error_message = "time stamp counter clocks are only supported on x86 Linux";
+  return make_unexpected(std::make_error_code(std::errc::not_supported));
+}
+#endif
+
+#ifdef __linux__
+static uint64_t ReadCoarseClock() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+expected<std::unique_ptr<Clock>> MakeCoarseClock(
+    std::string& error_message) noexcept try {
+  return std::unique_ptr<Clock>{new LinearClock<ReadCoarseClock>{
+      ReadCoarseClock(), SystemClock::now(), 1.0}};
+} catch (const std::exception& e) {
+  error_message = e.what();
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+}
+#else
+expected<std::unique_ptr<Clock>> MakeCoarseClock(
+    std::string& error_message) noexcept {
+  error_message = "coarse clocks are only supported on Linux";
+  return make_unexpected(std::make_error_code(std::errc::not_supported));
+}
+#endif
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,295 @@
+#include <fcntl.h>
+#include <opentracing/mocktracer/file_stream.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <streambuf>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+static const size_t BufferSize = 64 * 1024;
+
+// Writing to the stream blocks once this many buffers are waiting to be
+// written.
+static const size_t MaxPendingBuffers = 64;
+
+// Output handed over by a flush is written after at most this long, unless
+// enough follows to fill a buffer first.
+static const std::chrono::milliseconds MaxWriteDelay{10};
+
+#ifdef IOV_MAX
+static const size_t MaxIovecs = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+static const size_t MaxIovecs = 16;
+#endif
+
+namespace {
+class FileBuffer : public std::streambuf {
+ public:
+  explicit FileBuffer(int file_descriptor);
+
+  FileBuffer(const FileBuffer&) = delete;
+  FileBuffer& operator=(const FileBuffer&) = delete;
+
+  ~FileBuffer() override;
+
+ protected:
+  int_type overflow(int_type c) override;
+
+  int sync() override;
+
+ private:
+  int file_descriptor_;
+  std::string buffer_;
+
+  // mutex_ protects the members below.
+  std::mutex mutex_;
+  std::condition_variable pending_condition_;
+  // written_condition_ is signaled after each write.
+  std::condition_variable written_condition_;
+  std::vector<std::string> pending_buffers_;
+  std::vector<std::string> free_buffers_;
+  size_t pending_size_ = 0;
+  uint64_t submitted_size_ = 0;
+  uint64_t written_size_ = 0;
+  // When the pending buffers are due to be written, if there are any.
+  SteadyTime write_deadline_;
+  bool is_sync_requested_ = false;
+  bool is_closing_ = false;
+  bool has_error_ = false;
+
+  std::thread thread_;
+
+  void ResetPutArea();
+
+  bool Submit();
+
+  void Run() noexcept;
+
+  // Returns true if the pending buffers should be written now.
+  bool IsWriteReady() const noexcept {
+    return is_closing_ || is_sync_requested_ || pending_size_ >= BufferSize;
+  }
+
+  bool WriteBuffers(const std::vector<std::string>& buffers) noexcept;
+};
+
+class FileStream : public std::ostream {
+ public:
+  explicit FileStream(int file_descriptor)
+      : std::ostream{nullptr}, buffer_{file_descriptor} {
+    rdbuf(&buffer_);
+  }
+
+ private:
+  FileBuffer buffer_;
+};
+}  // anonymous namespace
+
+FileBuffer::FileBuffer(int file_descriptor)
+    : file_descriptor_{file_descriptor} {
+  ResetPutArea();
+  thread_ = std::thread{&FileBuffer::Run, this};
+}
+
+FileBuffer::~FileBuffer() {
+  Submit();
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    is_closing_ = true;
+  }
+  pending_condition_.notify_one();
+  thread_.join();
+  close(file_descriptor_);
+}
+
+void FileBuffer::ResetPutArea() {
+  buffer_.resize(BufferSize);
+  setp(&buffer_[0], &buffer_[0] + buffer_.size());
+}
+
+// Hands the buffered output to the background thread, appending it to the
+// last waiting buffer if it fits. Returns false if an earlier write failed.
+bool FileBuffer::Submit() {
+  buffer_.resize(static_cast<size_t>(pptr() - pbase()));
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (!buffer_.empty()) {
+    // The background thread sleeps until there's output, and then until the
+    // output is due.
+    auto was_idle = pending_buffers_.empty();
+    if (was_idle) {
+      write_deadline_ = SteadyClock::now() + MaxWriteDelay;
+    }
+    pending_size_ += buffer_.size();
+    submitted_size_ += buffer_.size();
+    if (!pending_buffers_.empty() &&
+        pending_buffers_.back().size() + buffer_.size() <= BufferSize) {
+      pending_buffers_.back().append(buffer_);
+    } else {
+      written_condition_.wait(lock, [this] {
+        return has_error_ || pending_buffers_.size() < MaxPendingBuffers;
+      });
+      pending_buffers_.emplace_back(std::move(buffer_));
+      if (free_buffers_.empty()) {
+        buffer_ = std::string{};
+      } else {
+        buffer_ = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+      }
+    }
+    if (was_idle || pending_size_ >= BufferSize) {
+      pending_condition_.notify_one();
+    }
+  }
+  auto has_error = has_error_;
+  lock.unlock();
+  ResetPutArea();
+  return !has_error;
+}
+
+FileBuffer::int_type FileBuffer::overflow(int_type c) {
+  if (!Submit()) {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+// Waits until everything written to the stream so far has been written to
+// the file.
+int FileBuffer::sync() {
+  if (!Submit()) {
+    return -1;
+  }
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto target_size = submitted_size_;
+  if (written_size_ < target_size) {
+    is_sync_requested_ = true;
+    pending_condition_.notify_one();
+    written_condition_.wait(lock, [this, target_size] {
+      return has_error_ || written_size_ >= target_size;
+    });
+  }
+  return has_error_ ? -1 : 0;
+}
+
+void FileBuffer::Run() noexcept {
+  std::vector<std::string> buffers;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      pending_condition_.wait(lock, [this] {
+        return IsWriteReady() || !pending_buffers_.empty();
+      });
+      if (!IsWriteReady()) {
+        pending_condition_.wait_until(lock, write_deadline_,
+                                      [this] { return IsWriteReady(); });
+      }
+      is_sync_requested_ = false;
+      if (pending_buffers_.empty()) {
+        if (is_closing_) {
+          return;
+        }
+        continue;
+      }
+      buffers.swap(pending_buffers_);
+      pending_size_ = 0;
+    }
+    auto success = WriteBuffers(buffers);
+    {
+      std::lock_guard<std::mutex> lock_guard{mutex_};
+      if (!success) {
+        has_error_ = true;
+      }
+      for (auto& buffer : buffers) {
+        written_size_ += buffer.size();
+      }
+      for (auto& buffer : buffers) {
+        if (free_buffers_.size() < MaxPendingBuffers) {
+          free_buffers_.emplace_back(std::move(buffer));
+        }
+      }
+    }
+    buffers.clear();
+    written_condition_.notify_all();
+  }
+}
+
+bool FileBuffer::WriteBuffers(
+    const std::vector<std::string>& buffers) noexcept {
+  iovec iovecs[MaxIovecs];
+  size_t buffer_index = 0;
+  size_t offset = 0;
+  while (buffer_index < buffers.size()) {
+    int num_iovecs = 0;
+    for (auto i = buffer_index;
+         i < buffers.size() && static_cast<size_t>(num_iovecs) < MaxIovecs;
+         ++i) {
+      auto& buffer = buffers[i];
+      auto first = i == buffer_index ? offset : 0;
+      iovecs[num_iovecs].iov_base = const_cast<char*>(buffer.data() + first);
+      iovecs[num_iovecs].iov_len = buffer.size() - first;
+      ++num_iovecs;
+    }
+    auto num_written = writev(file_descriptor_, iovecs, num_iovecs);
+    if (num_written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    // Skip past what was written, which may end partway through a buffer.
+    auto remaining = static_cast<size_t>(num_written);
+    while (buffer_index < buffers.size() &&
+           remaining >= buffers[buffer_index].size() - offset) {
+      remaining -= buffers[buffer_index].size() - offset;
+      ++buffer_index;
+      offset = 0;
+    }
+    offset += remaining;
+  }
+  return true;
+}
+
+expected<std::unique_ptr<std::ostream>> MakeFileStream(
+    const std::string& path, std::string& error_message) noexcept try {
+  auto file_descriptor =
+      open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (file_descriptor == -1) {
+    auto error_number = errno;
+    error_message = "failed to open file `" + path + "` (" +
+                    std::strerror(error_number) + ")";
+    return make_unexpected(
+        std::error_code{error_number, std::generic_category()});
+  }
+  try {
+    return std::unique_ptr<std::ostream>{new FileStream{file_descriptor}};
+  } catch (...) {
+    close(file_descriptor);
+    throw;
+  }
+} catch (const std::bad_alloc&) {
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+} catch (const std::system_error& e) {
+  // Starting the background thread failed.
+  error_message = e.what();
+  return make_unexpected(e.code());
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
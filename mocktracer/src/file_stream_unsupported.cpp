@@ -0,0 +1,28 @@
+#include <opentracing/mocktracer/file_stream.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <system_error>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+expected<std::unique_ptr<std::ostream>> MakeFileStream(
+    const std::string& path, std::string& error_message) noexcept try {
+  errno = 0;
+  std::unique_ptr<std::ostream> out{new std::ofstream{path}};
+  if (!out->good()) {
+    auto error_number = errno;
+    error_message = "failed to open file `" + path + "` (" +
+                    std::strerror(error_number) + ")";
+    return make_unexpected(
+        std::error_code{error_number, std::generic_category()});
+  }
+  return std::move(out);
+} catch (const std::bad_alloc&) {
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,149 @@
+#include <opentracing/mocktracer/flight_recorder.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "binary_encoding.h"
+#include "flight_recorder_format.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Uses 64-bit FNV-1a.
+uint64_t ComputeFlightRecordChecksum(uint32_t size, uint64_t position,
+                                     const char* data) {
+  uint64_t checksum = 0xcbf29ce484222325;
+  auto update = [&](const char* first, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+      checksum ^= static_cast<unsigned char>(first[i]);
+      checksum *= 0x100000001b3;
+    }
+  };
+  update(reinterpret_cast<const char*>(&size), sizeof(size));
+  update(reinterpret_cast<const char*>(&position), sizeof(position));
+  update(data, size);
+  return checksum;
+}
+
+void CopyToRing(char* ring, size_t ring_size, uint64_t position,
+                const char* data, size_t size) {
+  auto offset = static_cast<size_t>(position % ring_size);
+  auto first_size = std::min(size, ring_size - offset);
+  std::memcpy(ring + offset, data, first_size);
+  std::memcpy(ring, data + first_size, size - first_size);
+}
+
+void CopyFromRing(const char* ring, size_t ring_size, uint64_t position,
+                  char* data, size_t size) {
+  auto offset = static_cast<size_t>(position % ring_size);
+  auto first_size = std::min(size, ring_size - offset);
+  std::memcpy(data, ring + offset, first_size);
+  std::memcpy(data + first_size, ring, size - first_size);
+}
+
+// Returns the span of the record at the given ring offset, if there is a
+// record there that was completely written during the last lap of the ring.
+static bool ReadFlightRecord(const std::string& ring, uint64_t cursor,
+                             size_t offset, std::string& buffer,
+                             std::pair<uint64_t, SpanData>& record) {
+  auto ring_size = ring.size();
+  FlightRecordHeader record_header;
+  CopyFromRing(ring.data(), ring_size, offset,
+               reinterpret_cast<char*>(&record_header), sizeof(record_header));
+  if (record_header.magic != FlightRecordMagic ||
+      record_header.position % ring_size != offset ||
+      record_header.position > cursor) {
+    return false;
+  }
+  auto record_size = GetFlightRecordSize(record_header.size);
+  if (record_size > ring_size / 4 ||
+      record_size > cursor - record_header.position ||
+      cursor - record_header.position > ring_size) {
+    return false;
+  }
+  buffer.resize(record_header.size);
+  CopyFromRing(ring.data(), ring_size,
+               record_header.position + sizeof(record_header), &buffer[0],
+               buffer.size());
+  if (ComputeFlightRecordChecksum(record_header.size, record_header.position,
+                                  buffer.data()) != record_header.checksum) {
+    return false;
+  }
+  try {
+    SpanDecoder decoder;
+    decoder.Decode(buffer, record.second);
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  record.first = record_header.position;
+  return true;
+}
+
+expected<std::vector<SpanData>> ReadFlightRecording(
+    const std::string& path, std::string& error_message) noexcept try {
+  errno = 0;
+  std::ifstream in{path, std::ios::binary};
+  if (!in.good()) {
+    error_message = "failed to open file `" + path + "` (";
+    error_message += std::strerror(errno);
+    error_message += ")";
+    return make_unexpected(std::make_error_code(std::errc::io_error));
+  }
+
+  char header[FlightRecordingHeaderSize];
+  in.read(header, sizeof(header));
+  uint32_t version = 0;
+  uint64_t ring_size = 0;
+  uint64_t cursor = 0;
+  std::memcpy(&version, header + offsetof(FlightRecordingHeader, version),
+              sizeof(version));
+  std::memcpy(&ring_size, header + offsetof(FlightRecordingHeader, ring_size),
+              sizeof(ring_size));
+  std::memcpy(&cursor, header + offsetof(FlightRecordingHeader, cursor),
+              sizeof(cursor));
+  if (in.gcount() != sizeof(header) ||
+      std::memcmp(header, FlightRecordingMagic,
+                  sizeof(FlightRecordingMagic)) != 0 ||
+      version != FlightRecordingVersion || ring_size == 0 ||
+      ring_size % FlightRecordAlignment != 0) {
+    error_message = "`" + path + "` is not a flight recording";
+    return make_unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  std::string ring(static_cast<size_t>(ring_size), '\0');
+  in.read(&ring[0], static_cast<std::streamsize>(ring.size()));
+  if (static_cast<uint64_t>(in.gcount()) != ring_size) {
+    error_message = "flight recording `" + path + "` is truncated";
+    return make_unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  std::vector<std::pair<uint64_t, SpanData>> records;
+  std::pair<uint64_t, SpanData> record;
+  std::string buffer;
+  for (size_t offset = 0; offset < ring.size();
+       offset += FlightRecordAlignment) {
+    if (ReadFlightRecord(ring, cursor, offset, buffer, record)) {
+      records.emplace_back(std::move(record));
+    }
+  }
+  std::sort(records.begin(), records.end(),
+            [](const std::pair<uint64_t, SpanData>& lhs,
+               const std::pair<uint64_t, SpanData>& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  std::vector<SpanData> spans;
+  spans.reserve(records.size());
+  for (auto& position_span : records) {
+    spans.emplace_back(std::move(position_span.second));
+  }
+  return spans;
+} catch (const std::bad_alloc&) {
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,66 @@
+#ifndef OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_FORMAT_H
+#define OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_FORMAT_H
+
+#include <opentracing/version.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// A flight recording file is a page holding a FlightRecordingHeader, followed
+// by the ring.
+//
+// The cursor counts every byte ever reserved in the ring. A record reserved at
+// cursor value position starts at ring offset position % ring_size and wraps
+// around the end of the ring if needed. Each record is a FlightRecordHeader
+// followed by a span encoded with SpanEncoder::EncodeStandalone, padded to a
+// multiple of FlightRecordAlignment bytes.
+//
+// Fields are in native byte order, since a recording is read back on the
+// machine that wrote it.
+const char FlightRecordingMagic[4] = {'O', 'T', 'F', 'R'};
+const uint32_t FlightRecordingVersion = 1;
+const size_t FlightRecordingHeaderSize = 4096;
+
+const uint32_t FlightRecordMagic = 0x5350414e;
+const size_t FlightRecordAlignment = 8;
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "the cursor must have the layout of a uint64_t");
+
+struct FlightRecordingHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t ring_size;
+  std::atomic<uint64_t> cursor;
+};
+
+struct FlightRecordHeader {
+  uint32_t magic;
+  // The size of the encoded span.
+  uint32_t size;
+  uint64_t position;
+  // Covers size, position and the encoded span.
+  uint64_t checksum;
+};
+
+inline size_t GetFlightRecordSize(size_t span_size) {
+  auto size = sizeof(FlightRecordHeader) + span_size;
+  return (size + FlightRecordAlignment - 1) & ~(FlightRecordAlignment - 1);
+}
+
+uint64_t ComputeFlightRecordChecksum(uint32_t size, uint64_t position,
+                                     const char* data);
+
+// Copy data to and from the ring, wrapping around its end.
+void CopyToRing(char* ring, size_t ring_size, uint64_t position,
+                const char* data, size_t size);
+void CopyFromRing(const char* ring, size_t ring_size, uint64_t position,
+                  char* data, size_t size);
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_FLIGHT_RECORDER_FORMAT_H
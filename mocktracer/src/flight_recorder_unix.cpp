@@ -0,0 +1,169 @@
+#include <fcntl.h>
+#include <opentracing/mocktracer/flight_recorder.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#include "binary_encoding.h"
+#include "flight_recorder_format.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+namespace {
+class FlightRecorder : public Recorder {
+ public:
+  FlightRecorder(char* mapping, size_t mapping_size)
+      : mapping_{mapping},
+        mapping_size_{mapping_size},
+        header_{reinterpret_cast<FlightRecordingHeader*>(mapping)},
+        ring_{mapping + FlightRecordingHeaderSize},
+        ring_size_{mapping_size - FlightRecordingHeaderSize} {}
+
+  ~FlightRecorder() override { munmap(mapping_, mapping_size_); }
+
+  void RecordSpan(SpanData&& span_data) noexcept override;
+
+  // The page cache keeps the recording if the process dies, so this only
+  // schedules the write to disk.
+  void Close() noexcept override { msync(mapping_, mapping_size_, MS_ASYNC); }
+
+ private:
+  char* mapping_;
+  size_t mapping_size_;
+  FlightRecordingHeader* header_;
+  char* ring_;
+  size_t ring_size_;
+};
+}  // anonymous namespace
+
+void FlightRecorder::RecordSpan(SpanData&& span_data) noexcept try {
+  static thread_local SpanEncoder encoder;
+  static thread_local std::string record;
+  auto& encoded_span = encoder.EncodeStandalone(span_data);
+  auto record_size = GetFlightRecordSize(encoded_span.size());
+  if (record_size > ring_size_ / 4 ||
+      encoded_span.size() > std::numeric_limits<uint32_t>::max()) {
+    return;
+  }
+
+  FlightRecordHeader record_header;
+  record_header.magic = FlightRecordMagic;
+  record_header.size = static_cast<uint32_t>(encoded_span.size());
+  record_header.position =
+      header_->cursor.fetch_add(record_size, std::memory_order_relaxed);
+  record_header.checksum = ComputeFlightRecordChecksum(
+      record_header.size, record_header.position, encoded_span.data());
+
+  record.assign(reinterpret_cast<const char*>(&record_header),
+                sizeof(record_header));
+  record.append(encoded_span);
+  record.resize(record_size, '\0');
+  CopyToRing(ring_, ring_size_, record_header.position, record.data(),
+             record.size());
+} catch (const std::exception&) {
+  // Drop span.
+}
+
+static std::error_code MakeErrnoError(const char* operation,
+                                      const std::string& path,
+                                      std::string& error_message) {
+  auto error_number = errno;
+  error_message = std::string{operation} + " `" + path + "` (" +
+                  std::strerror(error_number) + ")";
+  return std::error_code{error_number, std::generic_category()};
+}
+
+static std::error_code MakeNotRecordingError(const std::string& path,
+                                            size_t ring_size,
+                                            std::string& error_message) {
+  error_message = "`" + path +
+                  "` isn't empty or a flight recording with a ring of " +
+                  std::to_string(ring_size) + " bytes";
+  return std::make_error_code(std::errc::file_exists);
+}
+
+expected<std::unique_ptr<Recorder>> MakeFlightRecorder(
+    const FlightRecorderOptions& options, std::string& error_message) noexcept
+    try {
+  const size_t page_size = 4096;
+  auto ring_size = (std::max(options.ring_size, page_size) + page_size - 1) &
+                   ~(page_size - 1);
+  auto file_size = FlightRecordingHeaderSize + ring_size;
+
+  auto file_descriptor =
+      open(options.path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (file_descriptor == -1) {
+    return make_unexpected(
+        MakeErrnoError("failed to open file", options.path, error_message));
+  }
+
+  struct stat file_status;
+  if (fstat(file_descriptor, &file_status) == -1) {
+    auto error_code =
+        MakeErrnoError("failed to stat file", options.path, error_message);
+    close(file_descriptor);
+    return make_unexpected(error_code);
+  }
+  // Only empty files and existing recordings of the same size are used, so
+  // that a mistaken path doesn't destroy someone else's file.
+  auto is_new = file_status.st_size == 0;
+  if (!is_new && static_cast<size_t>(file_status.st_size) != file_size) {
+    close(file_descriptor);
+    return make_unexpected(MakeNotRecordingError(options.path, ring_size,
+                                                 error_message));
+  }
+  if (is_new &&
+      ftruncate(file_descriptor, static_cast<off_t>(file_size)) == -1) {
+    auto error_code =
+        MakeErrnoError("failed to resize file", options.path, error_message);
+    close(file_descriptor);
+    return make_unexpected(error_code);
+  }
+
+  auto mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    auto error_code =
+        MakeErrnoError("failed to map file", options.path, error_message);
+    close(file_descriptor);
+    return make_unexpected(error_code);
+  }
+  // The mapping stays valid after the file is closed.
+  close(file_descriptor);
+
+  auto header = static_cast<FlightRecordingHeader*>(mapping);
+  if (!is_new && (std::memcmp(header->magic, FlightRecordingMagic,
+                              sizeof(FlightRecordingMagic)) != 0 ||
+                  header->version != FlightRecordingVersion ||
+                  header->ring_size != ring_size)) {
+    munmap(mapping, file_size);
+    return make_unexpected(MakeNotRecordingError(options.path, ring_size,
+                                                 error_message));
+  }
+  if (is_new) {
+    header->version = FlightRecordingVersion;
+    header->ring_size = ring_size;
+    new (&header->cursor) std::atomic<uint64_t>{0};
+    std::memcpy(header->magic, FlightRecordingMagic,
+                sizeof(FlightRecordingMagic));
+  }
+
+  try {
+    return std::unique_ptr<Recorder>{
+        new FlightRecorder{static_cast<char*>(mapping), file_size}};
+  } catch (const std::bad_alloc&) {
+    munmap(mapping, file_size);
+    throw;
+  }
+} catch (const std::bad_alloc&) {
+  return make_unexpected(std::make_error_code(std::errc::not_enough_memory));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
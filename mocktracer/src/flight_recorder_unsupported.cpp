@@ -0,0 +1,14 @@
+#include <opentracing/mocktracer/flight_recorder.h>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+expected<std::unique_ptr<Recorder>> MakeFlightRecorder(
+    const FlightRecorderOptions& /*options*/,
+    std::string& error_message) noexcept {
+  error_message = "flight recorder is not supported on this platform";
+  return make_unexpected(std::make_error_code(std::errc::not_supported));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
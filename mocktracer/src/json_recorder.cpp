@@ -1,27 +1,212 @@
 #include <opentracing/mocktracer/json.h>
 #include <opentracing/mocktracer/json_recorder.h>
+#include "json_writer.h"
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
+// Returns roughly how much memory a value takes up, counting the characters of
+// a string but not nested values.
+static size_t EstimateSize(const Value& value) noexcept {
+  if (value.is<std::string>()) {
+    return sizeof(Value) + value.get<std::string>().size();
+  }
+  return sizeof(Value);
+}
+
+// Returns roughly how much memory a span takes up, for max_buffered_bytes.
+static size_t EstimateSize(const SpanData& span_data) noexcept {
+  auto result = sizeof(SpanData) + span_data.operation_name.size() +
+                span_data.references.size() * sizeof(SpanReferenceData);
+  for (auto& baggage_item : span_data.span_context.baggage) {
+    result += baggage_item.first.size() + baggage_item.second.size();
+  }
+  for (auto& tag : span_data.tags) {
+    result += tag.first.size() + EstimateSize(tag.second);
+  }
+  for (auto& log_record : span_data.logs) {
+    result += sizeof(LogRecord);
+    for (auto& field : log_record.fields) {
+      result += field.first.size() + EstimateSize(field.second);
+    }
+  }
+  result += span_data.lazy_tags.size() * sizeof(span_data.lazy_tags[0]) +
+            span_data.lazy_log_fields.size() * sizeof(LazyLogField);
+  return result;
+}
+
 JsonRecorder::JsonRecorder(std::unique_ptr<std::ostream>&& out)
-    : out_{std::move(out)} {}
+    : JsonRecorder{std::move(out), JsonRecorderOptions{}} {}
+
+JsonRecorder::JsonRecorder(std::unique_ptr<std::ostream>&& out,
+                           const JsonRecorderOptions& options)
+    : out_{std::move(out)}, options_(options) {
+  if (options_.streaming && out_ != nullptr) {
+    thread_ = std::thread{&JsonRecorder::Run, this};
+  }
+}
+
+JsonRecorder::~JsonRecorder() { StopWriter(); }
 
 void JsonRecorder::RecordSpan(SpanData&& span_data) noexcept try {
-  std::lock_guard<std::mutex> lock_guard{mutex_};
-  spans_.emplace_back(std::move(span_data));
+  if (!options_.streaming || out_ == nullptr) {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    spans_.emplace_back(std::move(span_data));
+    return;
+  }
+
+  auto size = EstimateSize(span_data);
+  bool notify_writer;
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    if (buffered_size_ + size > options_.max_buffered_bytes) {
+      num_dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    spans_.emplace_back(std::move(span_data));
+    spans_size_ += size;
+    buffered_size_ += size;
+
+    // The writer thread sleeps until a span is recorded, and then until the
+    // spans are due.
+    if (spans_.size() == 1) {
+      first_buffered_timestamp_ = SteadyClock::now();
+    }
+    notify_writer = spans_.size() == 1 ||
+                    spans_.size() == options_.max_buffered_spans;
+  }
+  if (notify_writer) {
+    writer_condition_.notify_one();
+  }
 } catch (const std::exception&) {
   // Drop span.
 }
 
+bool JsonRecorder::Flush(SteadyTime deadline) noexcept try {
+  if (out_ == nullptr) {
+    return true;
+  }
+  std::lock_guard<std::mutex> write_lock_guard{write_mutex_};
+  return WriteBufferedSpans(deadline, true);
+} catch (const std::exception&) {
+  return false;
+}
+
+// The spans are left in the stream's buffer rather than flushed, since
+// flushing waits for the stream's writes.
+void JsonRecorder::Run() noexcept {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      writer_condition_.wait(
+          lock, [this] { return is_closing_ || !spans_.empty(); });
+      if (!IsWriteReady()) {
+        writer_condition_.wait_until(
+            lock, first_buffered_timestamp_ + options_.flush_interval,
+            [this] { return IsWriteReady(); });
+      }
+      if (is_closing_) {
+        // Close writes the spans that are left.
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> write_lock_guard{write_mutex_};
+    WriteBufferedSpans(SteadyTime::max(), false);
+  }
+}
+
+void JsonRecorder::StopWriter() noexcept {
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    if (is_closing_) {
+      return;
+    }
+    is_closing_ = true;
+  }
+  writer_condition_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+// Writes the spans left over from a flush that ran out of time, then swaps
+// out the spans recorded so far and writes them.
+//
+// Requires write_mutex_ to be held.
+bool JsonRecorder::WriteBufferedSpans(SteadyTime deadline,
+                                      bool flush_stream) noexcept try {
+  bool result;
+  try {
+    JsonWriter json_writer{*out_};
+    result = write_buffer_.empty() || WriteSpans(json_writer, deadline);
+    if (result) {
+      {
+        std::lock_guard<std::mutex> lock_guard{mutex_};
+        spans_.swap(write_buffer_);
+        write_buffer_size_ = spans_size_;
+        spans_size_ = 0;
+      }
+      result = WriteSpans(json_writer, deadline);
+    }
+    json_writer.Flush();
+    if (flush_stream) {
+      out_->flush();
+    }
+  } catch (const std::exception&) {
+    // Drop the spans that weren't written.
+    ClearWriteBuffer();
+    result = false;
+  }
+  return result;
+} catch (const std::exception&) {
+  return false;
+}
+
+// Writes the spans in write_buffer_ from write_index_ on until the deadline
+// passes. Spans that aren't written are kept there for the next flush, rather
+// than put back into spans_, which would copy them under mutex_.
+//
+// Requires write_mutex_ to be held.
+bool JsonRecorder::WriteSpans(JsonWriter& json_writer, SteadyTime deadline) {
+  auto num_spans = write_buffer_.size();
+  for (; write_index_ < num_spans && SteadyClock::now() < deadline;
+       ++write_index_) {
+    if (num_written_spans_++ == 0) {
+      json_writer.Write('[');
+    } else {
+      json_writer.Write(',');
+    }
+    json_writer.WriteSpan(write_buffer_[write_index_]);
+  }
+  if (write_index_ < num_spans) {
+    return false;
+  }
+  ClearWriteBuffer();
+  return true;
+}
+
+// Requires write_mutex_ to be held.
+void JsonRecorder::ClearWriteBuffer() noexcept {
+  write_buffer_.clear();
+  write_index_ = 0;
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  buffered_size_ -= write_buffer_size_;
+  write_buffer_size_ = 0;
+}
+
 void JsonRecorder::Close() noexcept try {
   if (out_ == nullptr) {
     return;
   }
-  std::lock_guard<std::mutex> lock_guard{mutex_};
-  ToJson(*out_, spans_);
+  StopWriter();
+  Flush();
+  std::lock_guard<std::mutex> write_lock_guard{write_mutex_};
+  if (num_written_spans_ == 0) {
+    *out_ << '[';
+  }
+  *out_ << ']';
   out_->flush();
-  spans_.clear();
+  num_written_spans_ = 0;
 } catch (const std::exception&) {
   // Ignore errors.
 }
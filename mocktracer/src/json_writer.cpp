@@ -0,0 +1,389 @@
+#include "json_writer.h"
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+// Define OPENTRACING_MOCKTRACER_NO_SSE2 to use the scalar escape scan even
+// where SSE2 is available, e.g. to compare the two with json_benchmark.
+#if !defined(OPENTRACING_MOCKTRACER_NO_SSE2) &&  \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define OPENTRACING_MOCKTRACER_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Buffered output is written to the stream once it grows past this size.
+static const size_t MaxBufferSize = 64 * 1024;
+
+static const char HexDigits[] = "0123456789abcdef";
+
+static const char DigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+JsonWriter::JsonWriter(std::ostream& out) : out_(out) {
+  buffer_.reserve(MaxBufferSize);
+}
+
+void JsonWriter::Flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+}
+
+void JsonWriter::WriteInteger(uint64_t value) {
+  char digits[20];
+  auto last = digits + sizeof(digits);
+  auto first = last;
+  while (value >= 100) {
+    auto index = static_cast<size_t>(value % 100) * 2;
+    value /= 100;
+    *--first = DigitPairs[index + 1];
+    *--first = DigitPairs[index];
+  }
+  if (value < 10) {
+    *--first = static_cast<char>('0' + value);
+  } else {
+    auto index = static_cast<size_t>(value) * 2;
+    *--first = DigitPairs[index + 1];
+    *--first = DigitPairs[index];
+  }
+  Write(first, static_cast<size_t>(last - first));
+}
+
+void JsonWriter::WriteInteger(int64_t value) {
+  if (value < 0) {
+    Write('-');
+    // Negate as unsigned so that the minimum value doesn't overflow.
+    WriteInteger(uint64_t{0} - static_cast<uint64_t>(value));
+  } else {
+    WriteInteger(static_cast<uint64_t>(value));
+  }
+}
+
+// Doubles are formatted as %g to match the default formatting of
+// std::ostream, which the JSON output has always used.
+void JsonWriter::WriteDouble(double value) {
+  char digits[32];
+  auto size = std::snprintf(digits, sizeof(digits), "%g", value);
+  if (size <= 0) {
+    return;
+  }
+  // snprintf uses the C locale's decimal point, so replace it with '.' in case
+  // the application changed LC_NUMERIC.
+  bool in_decimal_point = false;
+  for (int i = 0; i < size && i < static_cast<int>(sizeof(digits)) - 1; ++i) {
+    auto c = digits[i];
+    if (('0' <= c && c <= '9') || c == '-' || c == '+' || c == 'e') {
+      Write(c);
+      in_decimal_point = false;
+    } else if (!in_decimal_point) {
+      Write('.');
+      in_decimal_point = true;
+    }
+  }
+}
+
+void JsonWriter::WriteId(uint64_t id) {
+  char digits[18];
+  digits[0] = '"';
+  for (int i = 16; i > 0; --i) {
+    digits[i] = HexDigits[id & 0xf];
+    id >>= 4;
+  }
+  digits[17] = '"';
+  Write(digits, sizeof(digits));
+}
+
+static bool NeedsEscape(char c) {
+  auto u = static_cast<unsigned char>(c);
+  return u < 0x20 || u == '"' || u == '\\';
+}
+
+#ifdef OPENTRACING_MOCKTRACER_USE_SSE2
+static int CountTrailingZeros(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Returns a pointer to the first character in [first, last) that needs to be
+// escaped, or last if there is none.
+//
+// With SSE2, 16 characters are checked at a time; the remaining tail is
+// checked one character at a time.
+static const char* FindEscape(const char* first, const char* last) {
+#ifdef OPENTRACING_MOCKTRACER_USE_SSE2
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  const auto max_control = _mm_set1_epi8(0x1f);
+  while (last - first >= 16) {
+    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    // There's no unsigned byte comparison in SSE2, so c <= 0x1f is checked as
+    // min(c, 0x1f) == c.
+    auto is_control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk);
+    auto needs_escape =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                  _mm_cmpeq_epi8(chunk, backslash)),
+                     is_control);
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(needs_escape));
+    if (mask != 0) {
+      return first + CountTrailingZeros(mask);
+    }
+    first += 16;
+  }
+#endif
+  while (first != last && !NeedsEscape(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+// The implementation is based off of this answer from StackOverflow:
+// https://stackoverflow.com/a/33799784
+//
+// Runs of characters that don't need escaping are found with FindEscape and
+// copied in one go.
+void JsonWriter::WriteEscapedString(string_view s) {
+  Write('"');
+  auto first = s.data();
+  auto last = first + s.size();
+  while (true) {
+    auto escape = FindEscape(first, last);
+    Write(first, static_cast<size_t>(escape - first));
+    if (escape == last) {
+      break;
+    }
+    auto c = static_cast<unsigned char>(*escape);
+    first = escape + 1;
+    switch (c) {
+      case '"':
+        WriteLiteral(R"(\")");
+        break;
+      case '\\':
+        WriteLiteral(R"(\\)");
+        break;
+      case '\b':
+        WriteLiteral(R"(\b)");
+        break;
+      case '\n':
+        WriteLiteral(R"(\n)");
+        break;
+      case '\r':
+        WriteLiteral(R"(\r)");
+        break;
+      case '\t':
+        WriteLiteral(R"(\t)");
+        break;
+      default:
+        WriteLiteral(R"(\u00)");
+        Write(HexDigits[c >> 4]);
+        Write(HexDigits[c & 0xf]);
+    }
+  }
+  Write('"');
+}
+
+void JsonWriter::WriteSpanContext(const SpanContextData& span_context_data) {
+  WriteLiteral(R"({"trace_id":)");
+  WriteId(span_context_data.trace_id);
+  WriteLiteral(R"(,"span_id":)");
+  WriteId(span_context_data.span_id);
+  WriteLiteral(R"(,"baggage":{)");
+  auto num_baggage = span_context_data.baggage.size();
+  size_t baggage_index = 0;
+  for (auto& baggage_item : span_context_data.baggage) {
+    WriteEscapedString(baggage_item.first);
+    Write(':');
+    WriteEscapedString(baggage_item.second);
+    if (++baggage_index < num_baggage) {
+      Write(',');
+    }
+  }
+  WriteLiteral("}}");
+}
+
+void JsonWriter::WriteSpanReference(
+    const SpanReferenceData& span_reference_data) {
+  WriteLiteral(R"({"reference_type":)");
+  if (span_reference_data.reference_type == SpanReferenceType::ChildOfRef) {
+    WriteLiteral(R"("CHILD_OF")");
+  } else {
+    WriteLiteral(R"("FOLLOWS_FROM")");
+  }
+  WriteLiteral(R"(,"trace_id":)");
+  WriteId(span_reference_data.trace_id);
+  WriteLiteral(R"(,"span_id":)");
+  WriteId(span_reference_data.span_id);
+  Write('}');
+}
+
+struct JsonWriter::ValueVisitor {
+  JsonWriter& writer;
+
+  void operator()(bool value) {
+    if (value) {
+      writer.WriteLiteral("true");
+    } else {
+      writer.WriteLiteral("false");
+    }
+  }
+
+  void operator()(double value) {
+    if (std::isnan(value)) {
+      writer.WriteLiteral(R"("NaN")");
+    } else if (std::isinf(value)) {
+      if (std::signbit(value)) {
+        writer.WriteLiteral(R"("-Inf")");
+      } else {
+        writer.WriteLiteral(R"("+Inf")");
+      }
+    } else {
+      writer.WriteDouble(value);
+    }
+  }
+
+  void operator()(int64_t value) { writer.WriteInteger(value); }
+
+  void operator()(uint64_t value) { writer.WriteInteger(value); }
+
+  void operator()(const std::string& s) { writer.WriteEscapedString(s); }
+
+  void operator()(string_view s) { writer.WriteEscapedString(s); }
+
+  void operator()(std::nullptr_t) { writer.WriteLiteral("null"); }
+
+  void operator()(const char* s) { writer.WriteEscapedString(s); }
+
+  void operator()(const Values& values) {
+    writer.Write('[');
+    size_t i = 0;
+    for (const auto& value : values) {
+      writer.WriteValue(value);
+      if (++i < values.size()) {
+        writer.Write(',');
+      }
+    }
+    writer.Write(']');
+  }
+
+  void operator()(const Dictionary& dictionary) {
+    writer.Write('{');
+    size_t i = 0;
+    for (const auto& key_value : dictionary) {
+      writer.WriteEscapedString(key_value.first);
+      writer.Write(':');
+      writer.WriteValue(key_value.second);
+      if (++i < dictionary.size()) {
+        writer.Write(',');
+      }
+    }
+    writer.Write('}');
+  }
+};
+
+void JsonWriter::WriteValue(const Value& value) {
+  ValueVisitor value_visitor{*this};
+  apply_visitor(value_visitor, value);
+}
+
+void JsonWriter::WriteLogRecord(const LogRecord& log_record) {
+  WriteLiteral(R"({"timestamp":)");
+  WriteDuration(log_record.timestamp.time_since_epoch());
+  WriteLiteral(R"(,"fields":[)");
+  auto num_fields = log_record.fields.size();
+  size_t field_index = 0;
+  for (auto& field : log_record.fields) {
+    WriteLiteral(R"({"key":)");
+    WriteEscapedString(field.first);
+    WriteLiteral(R"(,"value":)");
+    WriteValue(field.second);
+    Write('}');
+    if (++field_index < num_fields) {
+      Write(',');
+    }
+  }
+  WriteLiteral("]}");
+}
+
+void JsonWriter::WriteSpan(const SpanData& span_data) {
+  if (HasLazyValues(span_data)) {
+    auto resolved = span_data;
+    ResolveLazyValues(resolved);
+    return WriteSpan(resolved);
+  }
+  WriteLiteral(R"({"span_context":)");
+  WriteSpanContext(span_data.span_context);
+
+  WriteLiteral(R"(,"references":[)");
+  auto num_references = span_data.references.size();
+  size_t reference_index = 0;
+  for (auto& reference : span_data.references) {
+    WriteSpanReference(reference);
+    if (++reference_index < num_references) {
+      Write(',');
+    }
+  }
+  Write(']');
+
+  WriteLiteral(R"(,"operation_name":)");
+  WriteEscapedString(span_data.operation_name);
+
+  WriteLiteral(R"(,"start_timestamp":)");
+  WriteDuration(span_data.start_timestamp.time_since_epoch());
+
+  WriteLiteral(R"(,"duration":)");
+  WriteDuration(span_data.duration);
+
+  WriteLiteral(R"(,"tags":{)");
+  auto num_tags = span_data.tags.size();
+  size_t tag_index = 0;
+  for (auto& tag : span_data.tags) {
+    WriteEscapedString(tag.first);
+    Write(':');
+    WriteValue(tag.second);
+    if (++tag_index < num_tags) {
+      Write(',');
+    }
+  }
+  Write('}');
+
+  WriteLiteral(R"(,"logs":[)");
+  auto num_logs = span_data.logs.size();
+  size_t log_index = 0;
+  for (auto& log : span_data.logs) {
+    WriteLogRecord(log);
+    if (++log_index < num_logs) {
+      Write(',');
+    }
+  }
+  WriteLiteral("]}");
+
+  if (buffer_.size() >= MaxBufferSize) {
+    Flush();
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
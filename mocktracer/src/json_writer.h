@@ -0,0 +1,66 @@
+#ifndef OPENTRACING_MOCKTRACER_JSON_WRITER_H
+#define OPENTRACING_MOCKTRACER_JSON_WRITER_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// JsonWriter serializes spans to JSON.
+//
+// Output is accumulated in a buffer and handed to the underlying stream with
+// a single write whenever the buffer grows past a threshold or Flush is
+// called, rather than formatting each token through the stream.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::ostream& out);
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  void Write(char c) { buffer_.push_back(c); }
+
+  void WriteSpan(const SpanData& span_data);
+
+  void WriteSpanContext(const SpanContextData& span_context_data);
+
+  // Writes any buffered output to the stream.
+  void Flush();
+
+ private:
+  std::ostream& out_;
+  std::string buffer_;
+
+  void Write(const char* s, size_t size) { buffer_.append(s, size); }
+
+  template <size_t N>
+  void WriteLiteral(const char (&s)[N]) {
+    buffer_.append(s, N - 1);
+  }
+
+  void WriteInteger(int64_t value);
+  void WriteInteger(uint64_t value);
+  void WriteDouble(double value);
+  void WriteId(uint64_t id);
+  void WriteEscapedString(string_view s);
+  void WriteValue(const Value& value);
+  void WriteSpanReference(const SpanReferenceData& span_reference_data);
+  void WriteLogRecord(const LogRecord& log_record);
+
+  template <class Rep, class Period>
+  void WriteDuration(const std::chrono::duration<Rep, Period>& duration) {
+    WriteInteger(static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count()));
+  }
+
+  struct ValueVisitor;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_JSON_WRITER_H
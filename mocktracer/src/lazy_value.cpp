@@ -0,0 +1,64 @@
+#include <opentracing/mocktracer/lazy_value.h>
+#include <opentracing/mocktracer/recorder.h>
+#include <cstdio>
+#include <vector>
+#include "mock_span.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+void SetLazyTag(Span& span, string_view key, const LazyValue& value) noexcept {
+  auto mock_span = dynamic_cast<MockSpan*>(&span);
+  if (mock_span != nullptr) {
+    return mock_span->SetLazyTag(key, value);
+  }
+  if (!span.IsRecording()) {
+    return;
+  }
+  try {
+    span.SetTag(key, value());
+  } catch (const std::exception& e) {
+    // Ignore upon error.
+    fprintf(stderr, "Failed to set tag: %s\n", e.what());
+  }
+}
+
+void LogLazy(
+    Span& span,
+    std::initializer_list<std::pair<string_view, LazyValue>> fields) noexcept {
+  auto mock_span = dynamic_cast<MockSpan*>(&span);
+  if (mock_span != nullptr) {
+    return mock_span->LogLazy(fields);
+  }
+  if (!span.IsRecording()) {
+    return;
+  }
+  try {
+    std::vector<std::pair<string_view, Value>> values;
+    values.reserve(fields.size());
+    for (auto& field : fields) {
+      values.emplace_back(field.first, field.second());
+    }
+    span.Log(SystemClock::now(), values);
+  } catch (const std::exception& e) {
+    // Drop log record upon error.
+    fprintf(stderr, "Failed to log: %s\n", e.what());
+  }
+}
+
+void ResolveLazyValues(SpanData& span_data) {
+  for (auto& tag : span_data.lazy_tags) {
+    span_data.tags.insert_or_assign(tag.first, tag.second());
+  }
+  span_data.lazy_tags.clear();
+  for (auto& field : span_data.lazy_log_fields) {
+    if (field.log_index < span_data.logs.size()) {
+      span_data.logs[field.log_index].fields.emplace_back(
+          std::move(field.key), field.value());
+    }
+  }
+  span_data.lazy_log_fields.clear();
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
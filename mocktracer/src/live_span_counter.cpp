@@ -0,0 +1,31 @@
+#include "live_span_counter.h"
+#include <chrono>
+#include <thread>
+#include "utility.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+const size_t LiveSpanCounter::NumShards;
+
+LiveSpanCounter::Shard& LiveSpanCounter::GetShard() noexcept {
+  return shards_[GetThreadIndex() % NumShards];
+}
+
+// Without concurrent starts the counters only decrease while they're summed,
+// so a sum of zero means that no span was live once it was taken.
+void LiveSpanCounter::WaitForSpans() const noexcept {
+  while (true) {
+    int64_t num_live_spans = 0;
+    for (auto& shard : shards_) {
+      num_live_spans += shard.count.load(std::memory_order_acquire);
+    }
+    if (num_live_spans == 0) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,52 @@
+#ifndef OPENTRACING_MOCKTRACER_LIVE_SPAN_COUNTER_H
+#define OPENTRACING_MOCKTRACER_LIVE_SPAN_COUNTER_H
+
+#include <opentracing/version.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// LiveSpanCounter counts the spans a tracer has started but not finished, so
+// that the tracer can wait for them before its recorder goes away.
+//
+// The count is spread over counters on separate cache lines, each updated by
+// a subset of the threads, so that starting and finishing spans on different
+// threads doesn't contend on one counter. A span may be finished on a
+// different thread than it was started on, so a single counter can go
+// negative; only the sum is meaningful.
+class LiveSpanCounter {
+ public:
+  void Increment() noexcept {
+    GetShard().count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Must be the last time a span touches its tracer when it's finished.
+  void Decrement() noexcept {
+    GetShard().count.fetch_sub(1, std::memory_order_release);
+  }
+
+  // Blocks until every span counted has been finished. Spans mustn't be
+  // started concurrently.
+  void WaitForSpans() const noexcept;
+
+ private:
+  static const size_t NumShards = 16;
+  static const size_t CacheLineSize = 64;
+
+  struct Shard {
+    std::atomic<int64_t> count{0};
+    char padding[CacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  Shard shards_[NumShards];
+
+  Shard& GetShard() noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_LIVE_SPAN_COUNTER_H
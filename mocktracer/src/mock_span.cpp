@@ -1,24 +1,26 @@
 #include "mock_span.h"
+#include <algorithm>
 #include <cstdio>
-#include <random>
+#include "utility.h"
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
 
-static uint64_t GenerateId() {
-  static thread_local std::mt19937_64 rand_source{std::random_device()()};
-  return static_cast<uint64_t>(rand_source());
-}
-
 static std::tuple<SystemTime, SteadyTime> ComputeStartTimestamps(
-    const SystemTime& start_system_timestamp,
+    const Clock* clock, const SystemTime& start_system_timestamp,
     const SteadyTime& start_steady_timestamp) {
   // If neither the system nor steady timestamps are set, get the tme from the
   // respective clocks; otherwise, use the set timestamp to initialize the
   // other.
   if (start_system_timestamp == SystemTime() &&
       start_steady_timestamp == SteadyTime()) {
+    // Span::Finish reads the steady clock, so the start's steady time is
+    // read from it too for the span's duration to be measured on one clock.
+    if (clock != nullptr) {
+      return std::tuple<SystemTime, SteadyTime>{
+          clock->ToSystemTime(clock->Now()), SteadyClock::now()};
+    }
     return std::tuple<SystemTime, SteadyTime>{SystemClock::now(),
                                               SteadyClock::now()};
   }
@@ -36,10 +38,25 @@ static std::tuple<SystemTime, SteadyTime> ComputeStartTimestamps(
                                             start_steady_timestamp};
 }
 
+// Removes the lazy tag with the given key, if there is one, so that a tag set
+// after it takes its place.
+static void EraseLazyTag(SpanData& span_data, string_view key) {
+  auto& lazy_tags = span_data.lazy_tags;
+  lazy_tags.erase(
+      std::remove_if(lazy_tags.begin(), lazy_tags.end(),
+                     [key](const std::pair<std::string, LazyValue>& tag) {
+                       return tag.first == key;
+                     }),
+      lazy_tags.end());
+}
+
+// Sets reference_data from reference and merges the referenced context's
+// baggage into baggage. Returns false if the reference isn't to a
+// MockSpanContext. is_remote is set if the context was extracted.
 static bool SetSpanReference(
     const std::pair<SpanReferenceType, const SpanContext*>& reference,
-    std::map<std::string, std::string>& baggage,
-    SpanReferenceData& reference_data) {
+    std::shared_ptr<const BaggageMap>& baggage,
+    SpanReferenceData& reference_data, bool& is_remote) {
   reference_data.reference_type = reference.first;
   if (reference.second == nullptr) {
     return false;
@@ -51,46 +68,57 @@ static bool SetSpanReference(
   }
   reference_data.trace_id = referenced_context->trace_id();
   reference_data.span_id = referenced_context->span_id();
-
-  referenced_context->ForeachBaggageItem(
-      [&baggage](const std::string& key, const std::string& value) {
-        baggage[key] = value;
-        return true;
-      });
-
+  is_remote = referenced_context->sampling_decision() ==
+              SamplingDecision::Undecided;
+  MergeBaggage(*referenced_context, baggage);
   return true;
 }
 
 MockSpan::MockSpan(std::shared_ptr<const Tracer>&& tracer, Recorder* recorder,
-                   string_view operation_name, const StartSpanOptions& options)
-    : tracer_{std::move(tracer)}, recorder_{recorder} {
+                   LiveSpanCounter* live_span_counter, const Clock* clock,
+                   bool thread_safe, uint64_t trace_id,
+                   string_view operation_name,
+                   const StartSpanOptions& options)
+    : tracer_{std::move(tracer)},
+      recorder_{recorder},
+      live_span_counter_{live_span_counter},
+      clock_{clock},
+      span_context_{thread_safe},
+      lock_{thread_safe} {
   data_.operation_name = operation_name;
 
   // Set start timestamps
-  std::tie(data_.start_timestamp, start_steady_) = ComputeStartTimestamps(
-      options.start_system_timestamp, options.start_steady_timestamp);
+  std::tie(data_.start_timestamp, start_steady_) =
+      ComputeStartTimestamps(clock_, options.start_system_timestamp,
+                             options.start_steady_timestamp);
 
   // Set references
-  SpanContextData span_context_data;
+  std::shared_ptr<const BaggageMap> baggage;
+  data_.references.reserve(options.references.size());
+  bool has_local_parent = false;
+  bool has_remote_parent = false;
   for (auto& reference : options.references) {
     SpanReferenceData reference_data;
-    if (!SetSpanReference(reference, span_context_data.baggage,
-                          reference_data)) {
+    bool is_remote = false;
+    if (!SetSpanReference(reference, baggage, reference_data, is_remote)) {
       continue;
     }
+    if (reference_data.reference_type == SpanReferenceType::ChildOfRef) {
+      (is_remote ? has_remote_parent : has_local_parent) = true;
+    }
     data_.references.push_back(reference_data);
   }
+  data_.has_remote_parent = has_remote_parent && !has_local_parent;
 
   // Set tags
+  data_.tags.reserve(options.tags.size());
   for (auto& tag : options.tags) {
-    data_.tags[tag.first] = tag.second;
+    data_.tags.insert_or_assign(tag.first, tag.second);
   }
 
   // Set span context
-  span_context_data.trace_id =
-      data_.references.empty() ? GenerateId() : data_.references[0].trace_id;
-  span_context_data.span_id = GenerateId();
-  span_context_ = MockSpanContext{std::move(span_context_data)};
+  span_context_ = MockSpanContext{trace_id, GenerateId(), std::move(baggage),
+                                  SamplingDecision::Sampled};
 }
 
 MockSpan::~MockSpan() {
@@ -122,10 +150,15 @@ void MockSpan::FinishWithOptions(const FinishSpanOptions& options) noexcept {
   if (recorder_ != nullptr) {
     recorder_->RecordSpan(std::move(data_));
   }
+
+  // The tracer may be destroyed as soon as this is decremented.
+  if (live_span_counter_ != nullptr) {
+    live_span_counter_->Decrement();
+  }
 }
 
 void MockSpan::SetOperationName(string_view name) noexcept try {
-  std::lock_guard<std::mutex> lock_guard{mutex_};
+  std::lock_guard<SpanLock> lock_guard{lock_};
   data_.operation_name = name;
 } catch (const std::exception& e) {
   // Ignore operation
@@ -134,8 +167,11 @@ void MockSpan::SetOperationName(string_view name) noexcept try {
 
 void MockSpan::SetTag(string_view key,
                       const opentracing::Value& value) noexcept try {
-  std::lock_guard<std::mutex> lock_guard{mutex_};
-  data_.tags[key] = value;
+  std::lock_guard<SpanLock> lock_guard{lock_};
+  data_.tags.insert_or_assign(key, value);
+  if (!data_.lazy_tags.empty()) {
+    EraseLazyTag(data_, key);
+  }
 } catch (const std::exception& e) {
   // Ignore upon error.
   fprintf(stderr, "Failed to set tag: %s\n", e.what());
@@ -143,7 +179,9 @@ void MockSpan::SetTag(string_view key,
 
 void MockSpan::Log(
     std::initializer_list<std::pair<string_view, Value>> fields) noexcept {
-  Log(SystemClock::now(), fields);
+  Log(clock_ != nullptr ? clock_->ToSystemTime(clock_->Now())
+                        : SystemClock::now(),
+      fields);
 }
 
 void MockSpan::Log(
@@ -155,7 +193,7 @@ void MockSpan::Log(
   for (auto& field : fields) {
     log_record.fields.emplace_back(field.first, field.second);
   }
-  std::lock_guard<std::mutex> lock_guard{mutex_};
+  std::lock_guard<SpanLock> lock_guard{lock_};
   data_.logs.emplace_back(std::move(log_record));
 } catch (const std::exception& e) {
   // Drop log record upon error.
@@ -171,7 +209,37 @@ void MockSpan::Log(
   for (auto& field : fields) {
     log_record.fields.emplace_back(field.first, field.second);
   }
-  std::lock_guard<std::mutex> lock_guard{mutex_};
+  std::lock_guard<SpanLock> lock_guard{lock_};
+  data_.logs.emplace_back(std::move(log_record));
+} catch (const std::exception& e) {
+  // Drop log record upon error.
+  fprintf(stderr, "Failed to log: %s\n", e.what());
+}
+
+void MockSpan::SetLazyTag(string_view key,
+                          const LazyValue& value) noexcept try {
+  std::lock_guard<SpanLock> lock_guard{lock_};
+  EraseLazyTag(data_, key);
+  data_.lazy_tags.emplace_back(key, value);
+} catch (const std::exception& e) {
+  // Ignore upon error.
+  fprintf(stderr, "Failed to set tag: %s\n", e.what());
+}
+
+void MockSpan::LogLazy(
+    std::initializer_list<std::pair<string_view, LazyValue>>
+        fields) noexcept try {
+  LogRecord log_record;
+  log_record.timestamp = clock_ != nullptr
+                             ? clock_->ToSystemTime(clock_->Now())
+                             : SystemClock::now();
+  std::lock_guard<SpanLock> lock_guard{lock_};
+  auto log_index = data_.logs.size();
+  data_.lazy_log_fields.reserve(data_.lazy_log_fields.size() + fields.size());
+  for (auto& field : fields) {
+    data_.lazy_log_fields.push_back(
+        LazyLogField{log_index, field.first, field.second});
+  }
   data_.logs.emplace_back(std::move(log_record));
 } catch (const std::exception& e) {
   // Drop log record upon error.
@@ -180,8 +248,7 @@ void MockSpan::Log(
 
 void MockSpan::SetBaggageItem(string_view restricted_key,
                               string_view value) noexcept try {
-  std::lock_guard<std::mutex> lock_guard{span_context_.baggage_mutex_};
-  span_context_.data_.baggage.emplace(restricted_key, value);
+  span_context_.SetBaggageItem(restricted_key, value);
 } catch (const std::exception& e) {
   // Drop baggage item upon error.
   fprintf(stderr, "Failed to set baggage item: %s\n", e.what());
@@ -189,12 +256,7 @@ void MockSpan::SetBaggageItem(string_view restricted_key,
 
 std::string MockSpan::BaggageItem(string_view restricted_key) const
     noexcept try {
-  std::lock_guard<std::mutex> lock_guard{span_context_.baggage_mutex_};
-  auto lookup = span_context_.data_.baggage.find(restricted_key);
-  if (lookup != span_context_.data_.baggage.end()) {
-    return lookup->second;
-  }
-  return {};
+  return span_context_.BaggageItem(restricted_key);
 } catch (const std::exception& e) {
   // Return empty string upon error.
   fprintf(stderr, "Failed to retrieve baggage item: %s\n", e.what());
@@ -3,8 +3,10 @@
 
 #include <opentracing/mocktracer/tracer.h>
 #include <atomic>
-#include <mutex>
+#include "live_span_counter.h"
 #include "mock_span_context.h"
+#include "span_lock.h"
+#include "span_pool.h"
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
@@ -12,11 +14,32 @@ namespace mocktracer {
 
 class MockSpan : public Span {
  public:
+  // trace_id is the id of the trace the span belongs to, which is that of the
+  // first span referenced in options if there is one. If clock is nullptr,
+  // timestamps are read from the std::chrono clocks. If live_span_counter
+  // isn't nullptr, it's decremented once the span has been recorded.
   MockSpan(std::shared_ptr<const Tracer>&& tracer, Recorder* recorder,
-           string_view operation_name, const StartSpanOptions& options);
+           LiveSpanCounter* live_span_counter, const Clock* clock,
+           bool thread_safe, uint64_t trace_id, string_view operation_name,
+           const StartSpanOptions& options);
 
   ~MockSpan() override;
 
+  // MockSpans are always allocated from a SpanPool so that they can be
+  // recycled when the tracer is configured with a span pool.
+  static void* operator new(size_t size, const SpanPool& span_pool) {
+    return span_pool.Allocate(size);
+  }
+
+  static void operator delete(void* ptr,
+                              const SpanPool& /*span_pool*/) noexcept {
+    SpanPool::Deallocate(ptr);
+  }
+
+  static void operator delete(void* ptr) noexcept {
+    SpanPool::Deallocate(ptr);
+  }
+
   void FinishWithOptions(const FinishSpanOptions& options) noexcept override;
 
   void SetOperationName(string_view name) noexcept override;
@@ -35,6 +58,12 @@ class MockSpan : public Span {
            const std::vector<std::pair<string_view, Value>>&
                fields) noexcept override;
 
+  // See mocktracer::SetLazyTag and mocktracer::LogLazy.
+  void SetLazyTag(string_view key, const LazyValue& value) noexcept;
+
+  void LogLazy(std::initializer_list<std::pair<string_view, LazyValue>>
+                   fields) noexcept;
+
   void SetBaggageItem(string_view restricted_key,
                       string_view value) noexcept override;
 
@@ -46,16 +75,20 @@ class MockSpan : public Span {
     return *tracer_;
   }
 
+  bool IsRecording() const noexcept override { return true; }
+
  private:
   std::shared_ptr<const Tracer> tracer_;
   Recorder* recorder_;
+  LiveSpanCounter* live_span_counter_;
+  const Clock* clock_;
   MockSpanContext span_context_;
   SteadyTime start_steady_;
 
   std::atomic<bool> is_finished_{false};
 
-  // Mutex protects data_
-  std::mutex mutex_;
+  // lock_ protects data_
+  SpanLock lock_;
   SpanData data_;
 };
 
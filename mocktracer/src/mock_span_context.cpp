@@ -4,34 +4,81 @@ namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
 MockSpanContext& MockSpanContext::operator=(MockSpanContext&& other) noexcept {
-  data_.trace_id = other.data_.trace_id;
-  data_.span_id = other.data_.span_id;
-  data_.baggage = std::move(other.data_.baggage);
+  trace_id_ = other.trace_id_;
+  span_id_ = other.span_id_;
+  baggage_ = std::move(other.baggage_);
+  sampling_decision_ = other.sampling_decision_;
   return *this;
 }
 
 void MockSpanContext::ForeachBaggageItem(
     std::function<bool(const std::string& key, const std::string& value)> f)
     const {
-  std::lock_guard<std::mutex> lock_guard{baggage_mutex_};
-  for (const auto& baggage_item : data_.baggage) {
+  auto baggage = this->baggage();
+  if (baggage == nullptr) {
+    return;
+  }
+  for (const auto& baggage_item : *baggage) {
     if (!f(baggage_item.first, baggage_item.second)) {
       return;
     }
   }
 }
 
+void MockSpanContext::SetBaggageItem(string_view key, string_view value) {
+  std::lock_guard<SpanLock> lock_guard{baggage_lock_};
+  if (baggage_ == nullptr || baggage_.use_count() > 1) {
+    baggage_ = std::shared_ptr<const BaggageMap>{
+        baggage_ == nullptr ? new BaggageMap{} : new BaggageMap{*baggage_}};
+  }
+  // Every map is created non-const above or in Extract, and no other context
+  // holds this one, so it can be modified in place.
+  const_cast<BaggageMap&>(*baggage_).emplace(key, value);
+}
+
+std::string MockSpanContext::BaggageItem(string_view key) const {
+  auto baggage = this->baggage();
+  if (baggage == nullptr) {
+    return {};
+  }
+  auto lookup = baggage->find(key);
+  if (lookup != baggage->end()) {
+    return lookup->second;
+  }
+  return {};
+}
+
 void MockSpanContext::CopyData(SpanContextData& data) const {
-  data.trace_id = data_.trace_id;
-  data.span_id = data_.span_id;
-  std::lock_guard<std::mutex> lock_guard{baggage_mutex_};
-  data.baggage = data_.baggage;
+  data.trace_id = trace_id_;
+  data.span_id = span_id_;
+  auto baggage = this->baggage();
+  if (baggage != nullptr) {
+    data.baggage = *baggage;
+  } else {
+    data.baggage.clear();
+  }
+}
+
+void MergeBaggage(const MockSpanContext& referenced_context,
+                  std::shared_ptr<const BaggageMap>& baggage) {
+  auto referenced_baggage = referenced_context.baggage();
+  if (referenced_baggage == nullptr || referenced_baggage->empty()) {
+    return;
+  }
+  if (baggage == nullptr) {
+    baggage = std::move(referenced_baggage);
+    return;
+  }
+  std::unique_ptr<BaggageMap> merged_baggage{new BaggageMap{*baggage}};
+  for (auto& baggage_item : *referenced_baggage) {
+    (*merged_baggage)[baggage_item.first] = baggage_item.second;
+  }
+  baggage = std::move(merged_baggage);
 }
 
 std::unique_ptr<SpanContext> MockSpanContext::Clone() const noexcept try {
-  auto result = std::unique_ptr<MockSpanContext>{new MockSpanContext{}};
-  CopyData(result->data_);
-  return std::unique_ptr<SpanContext>{result.release()};
+  return std::unique_ptr<SpanContext>{new MockSpanContext{
+      trace_id_, span_id_, baggage(), sampling_decision_}};
 } catch (const std::exception& /*e*/) {
   return nullptr;
 }
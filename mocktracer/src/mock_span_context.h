@@ -3,21 +3,41 @@
 
 #include <opentracing/mocktracer/tracer.h>
 #include <exception>
+#include <memory>
 #include <mutex>
 #include <string>
 #include "propagation.h"
+#include "span_lock.h"
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
 
-class MockSpan;
+enum class SamplingDecision {
+  // The context was extracted, so whether its trace is sampled isn't known.
+  Undecided,
+  Sampled,
+  NotSampled
+};
 
+// MockSpanContext's baggage is copy-on-write: cloning a context, or starting a
+// span from one, shares its baggage, which is only copied when a span sharing
+// it sets a baggage item.
 class MockSpanContext : public SpanContext {
  public:
   MockSpanContext() = default;
 
-  MockSpanContext(SpanContextData&& data) noexcept : data_(std::move(data)) {}
+  // If thread_safe is false, the context's baggage isn't protected by a lock.
+  explicit MockSpanContext(bool thread_safe) noexcept
+      : baggage_lock_{thread_safe} {}
+
+  MockSpanContext(uint64_t trace_id, uint64_t span_id,
+                  std::shared_ptr<const BaggageMap>&& baggage,
+                  SamplingDecision sampling_decision) noexcept
+      : sampling_decision_{sampling_decision},
+        trace_id_{trace_id},
+        span_id_{span_id},
+        baggage_{std::move(baggage)} {}
 
   MockSpanContext(const MockSpanContext&) = delete;
   MockSpanContext(MockSpanContext&&) = delete;
@@ -32,46 +52,84 @@ class MockSpanContext : public SpanContext {
       const override;
 
   std::string ToTraceID() const noexcept override try {
-    return std::to_string(data_.trace_id);
+    return std::to_string(trace_id_);
   } catch (const std::exception& /*e*/) {
     return {};
   }
 
   std::string ToSpanID() const noexcept override try {
-    return std::to_string(data_.span_id);
+    return std::to_string(span_id_);
   } catch (const std::exception& /*e*/) {
     return {};
   }
 
-  uint64_t trace_id() const noexcept { return data_.trace_id; }
+  bool IsSampled() const noexcept override {
+    return sampling_decision_ != SamplingDecision::NotSampled;
+  }
+
+  uint64_t trace_id() const noexcept { return trace_id_; }
+
+  uint64_t span_id() const noexcept { return span_id_; }
+
+  SamplingDecision sampling_decision() const noexcept {
+    return sampling_decision_;
+  }
+
+  // Returns the context's baggage, or nullptr if it has none.
+  std::shared_ptr<const BaggageMap> baggage() const noexcept {
+    std::lock_guard<SpanLock> lock_guard{baggage_lock_};
+    return baggage_;
+  }
+
+  void SetBaggageItem(string_view key, string_view value);
 
-  uint64_t span_id() const noexcept { return data_.span_id; }
+  std::string BaggageItem(string_view key) const;
 
   void CopyData(SpanContextData& data) const;
 
   template <class Carrier>
   expected<void> Inject(const PropagationOptions& propagation_options,
                         Carrier& writer) const {
-    std::lock_guard<std::mutex> lock_guard{baggage_mutex_};
-    return InjectSpanContext(propagation_options, writer, data_);
+    return InjectSpanContext(propagation_options, writer, trace_id_, span_id_,
+                             baggage().get());
   }
 
   template <class Carrier>
   expected<bool> Extract(const PropagationOptions& propagation_options,
                          Carrier& reader) {
-    std::lock_guard<std::mutex> lock_guard{baggage_mutex_};
-    return ExtractSpanContext(propagation_options, reader, data_);
+    SpanContextData data;
+    auto result = ExtractSpanContext(propagation_options, reader, data);
+    if (result && *result) {
+      trace_id_ = data.trace_id;
+      span_id_ = data.span_id;
+      if (!data.baggage.empty()) {
+        std::shared_ptr<const BaggageMap> baggage{
+            new BaggageMap{std::move(data.baggage)}};
+        std::lock_guard<SpanLock> lock_guard{baggage_lock_};
+        baggage_ = std::move(baggage);
+      }
+    }
+    return result;
   }
 
   std::unique_ptr<SpanContext> Clone() const noexcept override;
 
  private:
-  friend MockSpan;
-
-  mutable std::mutex baggage_mutex_;
-  SpanContextData data_;
+  mutable SpanLock baggage_lock_;
+  SamplingDecision sampling_decision_ = SamplingDecision::Undecided;
+  uint64_t trace_id_ = 0;
+  uint64_t span_id_ = 0;
+
+  // Null if the context has no baggage. Shared with other contexts while
+  // use_count() is more than one, so it's copied before being modified.
+  std::shared_ptr<const BaggageMap> baggage_;
 };
 
+// Adds the baggage of `referenced_context` to `baggage`, sharing the
+// referenced context's baggage if it's the first with any.
+void MergeBaggage(const MockSpanContext& referenced_context,
+                  std::shared_ptr<const BaggageMap>& baggage);
+
 }  // namespace mocktracer
 END_OPENTRACING_ABI_NAMESPACE
 }  // namespace opentracing
@@ -0,0 +1,17 @@
+#include <opentracing/mocktracer/otlp.h>
+#include "otlp_encoding.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+void ToOtlp(std::ostream& writer, const std::vector<SpanData>& spans,
+            const OtlpOptions& options) {
+  std::string buffer;
+  for (auto& span_data : spans) {
+    AppendOtlpSpan(span_data, buffer);
+  }
+  WriteOtlpResourceSpans(writer, options, buffer);
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
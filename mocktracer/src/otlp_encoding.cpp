@@ -0,0 +1,478 @@
+#include "otlp_encoding.h"
+#include <opentracing/ext/tags.h>
+#include <cstring>
+#include <limits>
+#include <ostream>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Field numbers are from the .proto files in
+// https://github.com/open-telemetry/opentelemetry-proto under
+// opentelemetry/proto/{trace,resource,common}/v1.
+namespace {
+enum WireType : uint32_t {
+  VarintWireType = 0,
+  Fixed64WireType = 1,
+  LengthDelimitedWireType = 2
+};
+
+namespace TracesDataField {
+const uint32_t ResourceSpans = 1;
+}
+
+namespace ResourceSpansField {
+const uint32_t Resource = 1;
+const uint32_t ScopeSpans = 2;
+}  // namespace ResourceSpansField
+
+namespace ResourceField {
+const uint32_t Attributes = 1;
+}
+
+namespace ScopeSpansField {
+const uint32_t Scope = 1;
+const uint32_t Spans = 2;
+}  // namespace ScopeSpansField
+
+namespace InstrumentationScopeField {
+const uint32_t Name = 1;
+}
+
+namespace SpanField {
+const uint32_t TraceId = 1;
+const uint32_t SpanId = 2;
+const uint32_t ParentSpanId = 4;
+const uint32_t Name = 5;
+const uint32_t Kind = 6;
+const uint32_t StartTimeUnixNano = 7;
+const uint32_t EndTimeUnixNano = 8;
+const uint32_t Attributes = 9;
+const uint32_t Events = 11;
+const uint32_t Links = 13;
+const uint32_t Status = 15;
+}  // namespace SpanField
+
+namespace EventField {
+const uint32_t TimeUnixNano = 1;
+const uint32_t Name = 2;
+const uint32_t Attributes = 3;
+}  // namespace EventField
+
+namespace LinkField {
+const uint32_t TraceId = 1;
+const uint32_t SpanId = 2;
+const uint32_t Attributes = 4;
+}  // namespace LinkField
+
+namespace StatusField {
+const uint32_t Code = 3;
+}
+
+namespace KeyValueField {
+const uint32_t Key = 1;
+const uint32_t Value = 2;
+}  // namespace KeyValueField
+
+namespace AnyValueField {
+const uint32_t StringValue = 1;
+const uint32_t BoolValue = 2;
+const uint32_t IntValue = 3;
+const uint32_t DoubleValue = 4;
+const uint32_t ArrayValue = 5;
+const uint32_t KvlistValue = 6;
+}  // namespace AnyValueField
+
+// ArrayValue and KeyValueList
+namespace ValuesField {
+const uint32_t Values = 1;
+}
+
+enum SpanKind : uint64_t {
+  SpanKindInternal = 1,
+  SpanKindServer = 2,
+  SpanKindClient = 3,
+  SpanKindProducer = 4,
+  SpanKindConsumer = 5
+};
+
+const uint64_t StatusCodeError = 2;
+
+// ProtobufWriter appends fields in the protobuf wire format to a buffer.
+//
+// The length of an embedded message isn't known until the message has been
+// written, so BeginMessage reserves a single byte for it and EndMessage fills
+// it in, shifting the message's contents over in the uncommon case that the
+// length needs more than one byte.
+class ProtobufWriter {
+ public:
+  explicit ProtobufWriter(std::string& buffer) : buffer_(buffer) {}
+
+  void WriteVarint(uint64_t x) {
+    char bytes[10];
+    buffer_.append(bytes, EncodeVarint(x, bytes));
+  }
+
+  void WriteTag(uint32_t field, WireType wire_type) {
+    WriteVarint((static_cast<uint64_t>(field) << 3) | wire_type);
+  }
+
+  void WriteVarintField(uint32_t field, uint64_t x) {
+    WriteTag(field, VarintWireType);
+    WriteVarint(x);
+  }
+
+  void WriteFixed64Field(uint32_t field, uint64_t x) {
+    WriteTag(field, Fixed64WireType);
+    char bytes[8];
+    for (auto& byte : bytes) {
+      byte = static_cast<char>(x & 0xff);
+      x >>= 8;
+    }
+    buffer_.append(bytes, sizeof(bytes));
+  }
+
+  void WriteDoubleField(uint32_t field, double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    WriteFixed64Field(field, bits);
+  }
+
+  void WriteBytesField(uint32_t field, const char* data, size_t size) {
+    WriteTag(field, LengthDelimitedWireType);
+    WriteVarint(size);
+    buffer_.append(data, size);
+  }
+
+  void WriteStringField(uint32_t field, string_view s) {
+    WriteBytesField(field, s.data(), s.size());
+  }
+
+  // Returns the position of the message's contents to pass to EndMessage.
+  size_t BeginMessage(uint32_t field) {
+    WriteTag(field, LengthDelimitedWireType);
+    buffer_.push_back('\0');
+    return buffer_.size();
+  }
+
+  void EndMessage(size_t position) {
+    char bytes[10];
+    auto size = EncodeVarint(buffer_.size() - position, bytes);
+    if (size > 1) {
+      buffer_.insert(position, size - 1, '\0');
+    }
+    buffer_.replace(position - 1, size, bytes, size);
+  }
+
+ private:
+  std::string& buffer_;
+
+  static size_t EncodeVarint(uint64_t x, char* bytes) {
+    size_t size = 0;
+    while (x >= 0x80) {
+      bytes[size++] = static_cast<char>((x & 0x7f) | 0x80);
+      x >>= 7;
+    }
+    bytes[size++] = static_cast<char>(x);
+    return size;
+  }
+};
+}  // anonymous namespace
+
+static void WriteSpanId(ProtobufWriter& writer, uint32_t field, uint64_t id) {
+  char bytes[8];
+  for (int i = 7; i >= 0; --i) {
+    bytes[i] = static_cast<char>(id & 0xff);
+    id >>= 8;
+  }
+  writer.WriteBytesField(field, bytes, sizeof(bytes));
+}
+
+static void WriteTraceId(ProtobufWriter& writer, uint32_t field, uint64_t id) {
+  char bytes[16] = {};
+  for (int i = 15; i >= 8; --i) {
+    bytes[i] = static_cast<char>(id & 0xff);
+    id >>= 8;
+  }
+  writer.WriteBytesField(field, bytes, sizeof(bytes));
+}
+
+static uint64_t ToUnixNanoseconds(SystemTime timestamp) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          timestamp.time_since_epoch())
+          .count());
+}
+
+static void WriteAnyValue(ProtobufWriter& writer, uint32_t field,
+                          const Value& value);
+
+static void WriteKeyValue(ProtobufWriter& writer, uint32_t field,
+                          string_view key, const Value& value) {
+  auto position = writer.BeginMessage(field);
+  writer.WriteStringField(KeyValueField::Key, key);
+  WriteAnyValue(writer, KeyValueField::Value, value);
+  writer.EndMessage(position);
+}
+
+namespace {
+struct AnyValueVisitor {
+  ProtobufWriter& writer;
+
+  void operator()(bool value) {
+    writer.WriteVarintField(AnyValueField::BoolValue, value ? 1 : 0);
+  }
+
+  void operator()(double value) {
+    writer.WriteDoubleField(AnyValueField::DoubleValue, value);
+  }
+
+  void operator()(int64_t value) {
+    writer.WriteVarintField(AnyValueField::IntValue,
+                            static_cast<uint64_t>(value));
+  }
+
+  // OTLP has no unsigned integers, so values that don't fit in an int64 are
+  // written as strings.
+  void operator()(uint64_t value) {
+    if (value <=
+        static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      writer.WriteVarintField(AnyValueField::IntValue, value);
+    } else {
+      writer.WriteStringField(AnyValueField::StringValue,
+                              std::to_string(value));
+    }
+  }
+
+  void operator()(const std::string& s) {
+    writer.WriteStringField(AnyValueField::StringValue, s);
+  }
+
+  void operator()(string_view s) {
+    writer.WriteStringField(AnyValueField::StringValue, s);
+  }
+
+  // An AnyValue with no value set represents null.
+  void operator()(std::nullptr_t) {}
+
+  void operator()(const char* s) {
+    writer.WriteStringField(AnyValueField::StringValue, s);
+  }
+
+  void operator()(const Values& values) {
+    auto position = writer.BeginMessage(AnyValueField::ArrayValue);
+    for (auto& value : values) {
+      WriteAnyValue(writer, ValuesField::Values, value);
+    }
+    writer.EndMessage(position);
+  }
+
+  void operator()(const Dictionary& dictionary) {
+    auto position = writer.BeginMessage(AnyValueField::KvlistValue);
+    for (auto& key_value : dictionary) {
+      WriteKeyValue(writer, ValuesField::Values, key_value.first,
+                    key_value.second);
+    }
+    writer.EndMessage(position);
+  }
+};
+
+// Gets the value of a tag or log field if it's a string.
+struct StringVisitor {
+  string_view& s;
+
+  template <class T>
+  bool operator()(const T&) const {
+    return false;
+  }
+
+  bool operator()(const std::string& value) const {
+    s = value;
+    return true;
+  }
+
+  bool operator()(string_view value) const {
+    s = value;
+    return true;
+  }
+
+  bool operator()(const char* value) const {
+    s = value;
+    return true;
+  }
+};
+}  // anonymous namespace
+
+static void WriteAnyValue(ProtobufWriter& writer, uint32_t field,
+                          const Value& value) {
+  auto position = writer.BeginMessage(field);
+  AnyValueVisitor value_visitor{writer};
+  apply_visitor(value_visitor, value);
+  writer.EndMessage(position);
+}
+
+static bool GetString(const Value& value, string_view& s) {
+  StringVisitor string_visitor{s};
+  return apply_visitor(string_visitor, value);
+}
+
+static uint64_t GetSpanKind(const SpanData& span_data) {
+  auto iter = span_data.tags.find(ext::span_kind);
+  string_view kind;
+  if (iter == span_data.tags.end() || !GetString(iter->second, kind)) {
+    return SpanKindInternal;
+  }
+  if (kind == ext::span_kind_rpc_server) {
+    return SpanKindServer;
+  }
+  if (kind == ext::span_kind_rpc_client) {
+    return SpanKindClient;
+  }
+  if (kind == "producer") {
+    return SpanKindProducer;
+  }
+  if (kind == "consumer") {
+    return SpanKindConsumer;
+  }
+  return SpanKindInternal;
+}
+
+static void WriteEvent(ProtobufWriter& writer, const LogRecord& log_record) {
+  auto position = writer.BeginMessage(SpanField::Events);
+  writer.WriteFixed64Field(EventField::TimeUnixNano,
+                           ToUnixNanoseconds(log_record.timestamp));
+  string_view name = "log";
+  const std::pair<std::string, Value>* name_field = nullptr;
+  for (auto& field : log_record.fields) {
+    if (field.first == "event" && GetString(field.second, name)) {
+      name_field = &field;
+      break;
+    }
+  }
+  writer.WriteStringField(EventField::Name, name);
+  for (auto& field : log_record.fields) {
+    if (&field != name_field) {
+      WriteKeyValue(writer, EventField::Attributes, field.first, field.second);
+    }
+  }
+  writer.EndMessage(position);
+}
+
+static void WriteLink(ProtobufWriter& writer,
+                      const SpanReferenceData& reference) {
+  auto position = writer.BeginMessage(SpanField::Links);
+  WriteTraceId(writer, LinkField::TraceId, reference.trace_id);
+  WriteSpanId(writer, LinkField::SpanId, reference.span_id);
+  WriteKeyValue(writer, LinkField::Attributes, "opentracing.ref_type",
+                reference.reference_type == SpanReferenceType::ChildOfRef
+                    ? "child_of"
+                    : "follows_from");
+  writer.EndMessage(position);
+}
+
+void AppendOtlpSpan(const SpanData& span_data, std::string& buffer) {
+  if (HasLazyValues(span_data)) {
+    auto resolved = span_data;
+    ResolveLazyValues(resolved);
+    return AppendOtlpSpan(resolved, buffer);
+  }
+  ProtobufWriter writer{buffer};
+  auto position = writer.BeginMessage(ScopeSpansField::Spans);
+  auto& span_context = span_data.span_context;
+  WriteTraceId(writer, SpanField::TraceId, span_context.trace_id);
+  WriteSpanId(writer, SpanField::SpanId, span_context.span_id);
+
+  const SpanReferenceData* parent = nullptr;
+  for (auto& reference : span_data.references) {
+    if (reference.reference_type == SpanReferenceType::ChildOfRef &&
+        reference.trace_id == span_context.trace_id) {
+      parent = &reference;
+      WriteSpanId(writer, SpanField::ParentSpanId, reference.span_id);
+      break;
+    }
+  }
+
+  writer.WriteStringField(SpanField::Name, span_data.operation_name);
+  writer.WriteVarintField(SpanField::Kind, GetSpanKind(span_data));
+  auto start_timestamp = ToUnixNanoseconds(span_data.start_timestamp);
+  writer.WriteFixed64Field(SpanField::StartTimeUnixNano, start_timestamp);
+  writer.WriteFixed64Field(
+      SpanField::EndTimeUnixNano,
+      start_timestamp + static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                span_data.duration)
+                                .count()));
+
+  bool is_error = false;
+  for (auto& tag : span_data.tags) {
+    if (tag.first == ext::span_kind) {
+      continue;
+    }
+    if (tag.first == ext::error && tag.second.is<bool>()) {
+      is_error = tag.second.get<bool>();
+      continue;
+    }
+    WriteKeyValue(writer, SpanField::Attributes, tag.first, tag.second);
+  }
+
+  for (auto& log_record : span_data.logs) {
+    WriteEvent(writer, log_record);
+  }
+
+  for (auto& reference : span_data.references) {
+    if (&reference != parent) {
+      WriteLink(writer, reference);
+    }
+  }
+
+  if (is_error) {
+    auto status_position = writer.BeginMessage(SpanField::Status);
+    writer.WriteVarintField(StatusField::Code, StatusCodeError);
+    writer.EndMessage(status_position);
+  }
+
+  writer.EndMessage(position);
+}
+
+void WriteOtlpResourceSpans(std::ostream& out, const OtlpOptions& options,
+                            const std::string& spans) {
+  // Everything but the spans is written to a separate buffer so that the
+  // spans don't need to be copied or shifted.
+  std::string scope;
+  ProtobufWriter scope_writer{scope};
+  auto scope_position = scope_writer.BeginMessage(ScopeSpansField::Scope);
+  scope_writer.WriteStringField(InstrumentationScopeField::Name, "mocktracer");
+  scope_writer.EndMessage(scope_position);
+
+  std::string resource;
+  ProtobufWriter resource_writer{resource};
+  auto resource_position =
+      resource_writer.BeginMessage(ResourceSpansField::Resource);
+  if (!options.service_name.empty()) {
+    WriteKeyValue(resource_writer, ResourceField::Attributes, "service.name",
+                  options.service_name);
+  }
+  resource_writer.EndMessage(resource_position);
+
+  std::string header;
+  ProtobufWriter header_writer{header};
+  header_writer.WriteTag(TracesDataField::ResourceSpans,
+                         LengthDelimitedWireType);
+  auto scope_spans_size = scope.size() + spans.size();
+  std::string scope_spans_header;
+  ProtobufWriter scope_spans_header_writer{scope_spans_header};
+  scope_spans_header_writer.WriteTag(ResourceSpansField::ScopeSpans,
+                                     LengthDelimitedWireType);
+  scope_spans_header_writer.WriteVarint(scope_spans_size);
+  header_writer.WriteVarint(resource.size() + scope_spans_header.size() +
+                            scope_spans_size);
+  header.append(resource);
+  header.append(scope_spans_header);
+  header.append(scope);
+
+  out.write(header.data(), static_cast<std::streamsize>(header.size()));
+  out.write(spans.data(), static_cast<std::streamsize>(spans.size()));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
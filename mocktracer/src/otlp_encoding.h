@@ -0,0 +1,25 @@
+#ifndef OPENTRACING_MOCKTRACER_OTLP_ENCODING_H
+#define OPENTRACING_MOCKTRACER_OTLP_ENCODING_H
+
+#include <opentracing/mocktracer/otlp.h>
+#include <opentracing/mocktracer/recorder.h>
+#include <iosfwd>
+#include <string>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Appends span_data to buffer as an element of the spans field of
+// opentelemetry.proto.trace.v1.ScopeSpans.
+void AppendOtlpSpan(const SpanData& span_data, std::string& buffer);
+
+// Writes spans, a buffer of spans appended by AppendOtlpSpan, to out as an
+// element of the resource_spans field of
+// opentelemetry.proto.trace.v1.TracesData.
+void WriteOtlpResourceSpans(std::ostream& out, const OtlpOptions& options,
+                            const std::string& spans);
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_OTLP_ENCODING_H
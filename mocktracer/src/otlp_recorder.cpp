@@ -0,0 +1,56 @@
+#include <opentracing/mocktracer/otlp_recorder.h>
+#include <ostream>
+#include "otlp_encoding.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+OtlpRecorder::OtlpRecorder(std::unique_ptr<std::ostream>&& out)
+    : OtlpRecorder{std::move(out), OtlpOptions{}} {}
+
+OtlpRecorder::OtlpRecorder(std::unique_ptr<std::ostream>&& out,
+                           const OtlpOptions& options)
+    : out_{std::move(out)}, options_(options) {}
+
+void OtlpRecorder::RecordSpan(SpanData&& span_data) noexcept try {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (out_ == nullptr) {
+    return;
+  }
+  auto size = spans_.size();
+  try {
+    AppendOtlpSpan(span_data, spans_);
+  } catch (const std::exception&) {
+    spans_.resize(size);
+    throw;
+  }
+  if (++num_buffered_spans_ >= options_.max_buffered_spans) {
+    WriteSpans();
+  }
+} catch (const std::exception&) {
+  // Drop span.
+}
+
+// Requires mutex_ to be held.
+void OtlpRecorder::WriteSpans() {
+  if (num_buffered_spans_ == 0) {
+    return;
+  }
+  WriteOtlpResourceSpans(*out_, options_, spans_);
+  spans_.clear();
+  num_buffered_spans_ = 0;
+}
+
+void OtlpRecorder::Close() noexcept try {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (out_ == nullptr) {
+    return;
+  }
+  WriteSpans();
+  out_->flush();
+} catch (const std::exception&) {
+  // Ignore errors.
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -25,19 +25,21 @@ static void ReadString(std::istream& istream, std::string& s) {
 
 expected<void> InjectSpanContext(
     const PropagationOptions& /*propagation_options*/, std::ostream& carrier,
-    const SpanContextData& span_context_data) {
-  auto trace_id = SwapEndianIfBig(span_context_data.trace_id);
+    uint64_t trace_id, uint64_t span_id, const BaggageMap* baggage) {
+  trace_id = SwapEndianIfBig(trace_id);
   carrier.write(reinterpret_cast<const char*>(&trace_id), sizeof(trace_id));
-  auto span_id = SwapEndianIfBig(span_context_data.span_id);
+  span_id = SwapEndianIfBig(span_id);
   carrier.write(reinterpret_cast<const char*>(&span_id), sizeof(span_id));
 
-  const uint32_t num_baggage =
-      SwapEndianIfBig(static_cast<uint32_t>(span_context_data.baggage.size()));
+  const uint32_t num_baggage = SwapEndianIfBig(
+      static_cast<uint32_t>(baggage != nullptr ? baggage->size() : 0));
   carrier.write(reinterpret_cast<const char*>(&num_baggage),
                 sizeof(num_baggage));
-  for (auto& baggage_item : span_context_data.baggage) {
-    WriteString(carrier, baggage_item.first);
-    WriteString(carrier, baggage_item.second);
+  if (baggage != nullptr) {
+    for (auto& baggage_item : *baggage) {
+      WriteString(carrier, baggage_item.first);
+      WriteString(carrier, baggage_item.second);
+    }
   }
 
   // Flush so that when we call carrier.good(), we'll get an accurate view of
@@ -93,10 +95,11 @@ expected<bool> ExtractSpanContext(
 
 expected<void> InjectSpanContext(const PropagationOptions& propagation_options,
                                  const TextMapWriter& carrier,
-                                 const SpanContextData& span_context_data) {
+                                 uint64_t trace_id, uint64_t span_id,
+                                 const BaggageMap* baggage) {
   std::ostringstream ostream;
-  auto result =
-      InjectSpanContext(propagation_options, ostream, span_context_data);
+  auto result = InjectSpanContext(propagation_options, ostream, trace_id,
+                                  span_id, baggage);
   if (!result) {
     return result;
   }
@@ -189,10 +192,11 @@ expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
 
 expected<void> InjectSpanContext(const PropagationOptions& propagation_options,
                                  const HTTPHeadersWriter& carrier,
-                                 const SpanContextData& span_context_data) {
+                                 uint64_t trace_id, uint64_t span_id,
+                                 const BaggageMap* baggage) {
   return InjectSpanContext(propagation_options,
                            static_cast<const TextMapWriter&>(carrier),
-                           span_context_data);
+                           trace_id, span_id, baggage);
 }
 
 expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
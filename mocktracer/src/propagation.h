@@ -4,14 +4,20 @@
 #include <opentracing/mocktracer/recorder.h>
 #include <opentracing/mocktracer/tracer.h>
 #include <opentracing/propagation.h>
+#include <map>
+#include <string>
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
 namespace mocktracer {
+using BaggageMap = std::map<std::string, std::string>;
+
+// baggage may be null if there's none.
 
 expected<void> InjectSpanContext(const PropagationOptions& propagation_options,
                                  std::ostream& carrier,
-                                 const SpanContextData& span_context_data);
+                                 uint64_t trace_id, uint64_t span_id,
+                                 const BaggageMap* baggage);
 
 expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
                                   std::istream& carrier,
@@ -19,7 +25,8 @@ expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
 
 expected<void> InjectSpanContext(const PropagationOptions& propagation_options,
                                  const TextMapWriter& carrier,
-                                 const SpanContextData& span_context_data);
+                                 uint64_t trace_id, uint64_t span_id,
+                                 const BaggageMap* baggage);
 
 expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
                                   const TextMapReader& carrier,
@@ -27,7 +34,8 @@ expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
 
 expected<void> InjectSpanContext(const PropagationOptions& propagation_options,
                                  const HTTPHeadersWriter& carrier,
-                                 const SpanContextData& span_context_data);
+                                 uint64_t trace_id, uint64_t span_id,
+                                 const BaggageMap* baggage);
 
 expected<bool> ExtractSpanContext(const PropagationOptions& propagation_options,
                                   const HTTPHeadersReader& carrier,
@@ -0,0 +1,44 @@
+#include <opentracing/mocktracer/sampler.h>
+#include <algorithm>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+ProbabilisticSampler::ProbabilisticSampler(double probability) noexcept
+    : threshold_{0}, sample_all_{probability >= 1.0} {
+  if (probability > 0.0 && !sample_all_) {
+    // 2^64 times the probability, which is below 2^64 and so fits.
+    threshold_ = static_cast<uint64_t>(probability * 18446744073709551616.0);
+  }
+}
+
+bool ProbabilisticSampler::ShouldSample(
+    uint64_t trace_id, string_view /*operation_name*/) noexcept {
+  return sample_all_ || trace_id < threshold_;
+}
+
+RateLimitingSampler::RateLimitingSampler(double max_traces_per_second) noexcept
+    : credits_per_second_{std::max(max_traces_per_second, 0.0)},
+      max_credits_{std::max(max_traces_per_second, 1.0)},
+      credits_{credits_per_second_ > 0 ? max_credits_ : 0},
+      last_timestamp_{SteadyClock::now()} {}
+
+bool RateLimitingSampler::ShouldSample(
+    uint64_t /*trace_id*/, string_view /*operation_name*/) noexcept {
+  auto now = SteadyClock::now();
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  auto elapsed = std::chrono::duration<double>(now - last_timestamp_).count();
+  if (elapsed > 0) {
+    credits_ =
+        std::min(max_credits_, credits_ + elapsed * credits_per_second_);
+    last_timestamp_ = now;
+  }
+  if (credits_ < 1.0) {
+    return false;
+  }
+  credits_ -= 1.0;
+  return true;
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
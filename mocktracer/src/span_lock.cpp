@@ -0,0 +1,28 @@
+#include "span_lock.h"
+#include <cstdint>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+namespace {
+// Enough mutexes that spans rarely share one with a span locked at the same
+// time, each on its own cache line so that they don't contend through it.
+const int kNumMutexBits = 8;
+
+struct alignas(64) PaddedMutex {
+  std::mutex mutex;
+};
+
+PaddedMutex mutexes[1 << kNumMutexBits];
+}  // anonymous namespace
+
+std::mutex& SpanLock::GetMutex(const SpanLock* lock) noexcept {
+  // Mix the address with Fibonacci hashing so that spans, which are all the
+  // same size, spread over every mutex.
+  auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(lock));
+  auto index = (address * 0x9e3779b97f4a7c15) >> (64 - kNumMutexBits);
+  return mutexes[index].mutex;
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,48 @@
+#ifndef OPENTRACING_MOCKTRACER_SPAN_LOCK_H
+#define OPENTRACING_MOCKTRACER_SPAN_LOCK_H
+
+#include <opentracing/version.h>
+#include <mutex>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// SpanLock guards the mutable state of a span or span context. It satisfies
+// the BasicLockable requirements so it can be used with std::lock_guard.
+//
+// Rather than embedding a std::mutex, which would make every span larger, it
+// points to one of a fixed set of mutexes picked by its address; when
+// constructed with thread_safe = false, it points to none and locking does
+// nothing. Unrelated spans may share a mutex, so a thread must not lock a
+// SpanLock while holding another.
+class SpanLock {
+ public:
+  explicit SpanLock(bool thread_safe = true) noexcept
+      : mutex_{thread_safe ? &GetMutex(this) : nullptr} {}
+
+  SpanLock(const SpanLock&) = delete;
+  SpanLock& operator=(const SpanLock&) = delete;
+
+  void lock() {
+    if (mutex_ != nullptr) {
+      mutex_->lock();
+    }
+  }
+
+  void unlock() noexcept {
+    if (mutex_ != nullptr) {
+      mutex_->unlock();
+    }
+  }
+
+ private:
+  std::mutex* mutex_;
+
+  // Returns the mutex for the lock at the given address.
+  static std::mutex& GetMutex(const SpanLock* lock) noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_SPAN_LOCK_H
@@ -0,0 +1,95 @@
+#include "span_pool.h"
+#include <new>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+namespace {
+struct BlockHeader {
+  size_t size;
+  size_t capacity;
+  BlockHeader* next;
+};
+
+// Pad the header so that the memory following it keeps the alignment
+// guarantees of ::operator new.
+union PaddedBlockHeader {
+  BlockHeader header;
+  long double long_double_alignment;
+  void* pointer_alignment;
+};
+
+// FreeList is trivially destructible, so that it can still be checked after
+// FreeListReleaser has released it during the thread's exit, when spans held
+// by other thread_local objects may still be destroyed.
+struct FreeList {
+  BlockHeader* head;
+  size_t size;
+  bool is_released;
+};
+
+thread_local FreeList free_list;
+
+struct FreeListReleaser {
+  ~FreeListReleaser() {
+    while (free_list.head != nullptr) {
+      auto next = free_list.head->next;
+      ::operator delete(static_cast<void*>(free_list.head));
+      free_list.head = next;
+    }
+    free_list.size = 0;
+    free_list.is_released = true;
+  }
+};
+}  // namespace
+
+// Returns the calling thread's free list, or nullptr if it was released.
+static FreeList* GetFreeList() noexcept {
+  if (free_list.is_released) {
+    return nullptr;
+  }
+  static thread_local FreeListReleaser free_list_releaser;
+  return &free_list;
+}
+
+static const BlockHeader* GetBlockHeader(const void* ptr) noexcept {
+  return reinterpret_cast<const BlockHeader*>(static_cast<const char*>(ptr) -
+                                              sizeof(PaddedBlockHeader));
+}
+
+void* SpanPool::Allocate(size_t size) const {
+  BlockHeader* block = nullptr;
+  auto free_list = capacity_ > 0 ? GetFreeList() : nullptr;
+  if (free_list != nullptr && free_list->head != nullptr &&
+      free_list->head->size == size) {
+    block = free_list->head;
+    free_list->head = block->next;
+    --free_list->size;
+  }
+  if (block == nullptr) {
+    block = static_cast<BlockHeader*>(
+        ::operator new(sizeof(PaddedBlockHeader) + size));
+    block->size = size;
+  }
+  block->capacity = capacity_;
+  block->next = nullptr;
+  return reinterpret_cast<char*>(block) + sizeof(PaddedBlockHeader);
+}
+
+void SpanPool::Deallocate(void* ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto block = const_cast<BlockHeader*>(GetBlockHeader(ptr));
+  auto free_list = block->capacity > 0 ? GetFreeList() : nullptr;
+  if (free_list != nullptr && free_list->size < block->capacity) {
+    block->next = free_list->head;
+    free_list->head = block;
+    ++free_list->size;
+    return;
+  }
+  ::operator delete(static_cast<void*>(block));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,38 @@
+#ifndef OPENTRACING_MOCKTRACER_SPAN_POOL_H
+#define OPENTRACING_MOCKTRACER_SPAN_POOL_H
+
+#include <opentracing/version.h>
+#include <cstddef>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// SpanPool allocates the memory for MockSpans.
+//
+// Every block is prefixed with a small header that records the pool's
+// capacity. When a block is deallocated it's pushed onto a free list owned by
+// the deallocating thread, provided that thread's free list holds fewer than
+// capacity blocks; otherwise, it's returned to the heap. A capacity of zero
+// disables pooling.
+//
+// Only the span objects are pooled: a span's SpanData is moved into the
+// recorder when it finishes, so its containers' capacity leaves with it.
+//
+// A thread's free list is released when the thread exits; blocks given back
+// after that go to the heap.
+class SpanPool {
+ public:
+  explicit SpanPool(size_t capacity) noexcept : capacity_{capacity} {}
+
+  void* Allocate(size_t size) const;
+
+  static void Deallocate(void* ptr) noexcept;
+
+ private:
+  size_t capacity_;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_SPAN_POOL_H
@@ -0,0 +1,90 @@
+#include "span_queue.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+static size_t RoundUpToPowerOfTwo(size_t x) {
+  size_t result = 1;
+  while (result < x) {
+    result <<= 1;
+  }
+  return result;
+}
+
+SpanQueue::SpanQueue(size_t capacity)
+    : mask_{RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity) - 1},
+      enqueue_position_{0},
+      dequeue_position_{0} {
+  cells_.reset(new Cell[mask_ + 1]);
+  for (size_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool SpanQueue::TryPush(SpanData&& span_data) noexcept {
+  Cell* cell;
+  auto position = enqueue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((position & ClosedFlag) != 0) {
+      return false;
+    }
+    cell = &cells_[position & mask_];
+    auto sequence = cell->sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The consumer hasn't yet taken the span pushed into this cell a full
+      // lap ago, so the queue is full.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->span_data = std::move(span_data);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool SpanQueue::TryPop(SpanData& span_data) noexcept {
+  auto position = dequeue_position_.load(std::memory_order_relaxed);
+  auto& cell = cells_[position & mask_];
+  auto sequence = cell.sequence.load(std::memory_order_acquire);
+  if (sequence != position + 1) {
+    return false;
+  }
+  span_data = std::move(cell.span_data);
+  cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+  dequeue_position_.store(position + 1, std::memory_order_relaxed);
+  return true;
+}
+
+void SpanQueue::Close() noexcept {
+  // A push that loses the race fails its compare-exchange and then sees the
+  // flag; the cells of those that win are published by their sequence.
+  enqueue_position_.fetch_or(ClosedFlag, std::memory_order_relaxed);
+}
+
+bool SpanQueue::IsDrained() const noexcept {
+  auto enqueue_position = enqueue_position_.load(std::memory_order_relaxed);
+  return (enqueue_position & ClosedFlag) != 0 &&
+         dequeue_position_.load(std::memory_order_relaxed) ==
+             (enqueue_position & ~ClosedFlag);
+}
+
+size_t SpanQueue::size() const noexcept {
+  auto dequeue_position = dequeue_position_.load(std::memory_order_relaxed);
+  auto enqueue_position =
+      enqueue_position_.load(std::memory_order_relaxed) & ~ClosedFlag;
+  if (enqueue_position < dequeue_position) {
+    return 0;
+  }
+  return enqueue_position - dequeue_position;
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
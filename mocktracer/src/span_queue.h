@@ -0,0 +1,77 @@
+#ifndef OPENTRACING_MOCKTRACER_SPAN_QUEUE_H
+#define OPENTRACING_MOCKTRACER_SPAN_QUEUE_H
+
+#include <opentracing/mocktracer/recorder.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// SpanQueue is a bounded, lock-free queue of spans that supports any number of
+// producers and a single consumer.
+//
+// The implementation is based off of Dmitry Vyukov's bounded MPMC queue:
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// Each cell carries a sequence number that tells producers and the consumer
+// whose turn it is to use the cell, so a producer only contends with other
+// producers on the enqueue position. Closing the queue sets a flag in the
+// enqueue position, so producers see it without touching any other shared
+// state.
+class SpanQueue {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SpanQueue(size_t capacity);
+
+  SpanQueue(const SpanQueue&) = delete;
+  SpanQueue& operator=(const SpanQueue&) = delete;
+
+  // Returns false if the queue is full or closed. May be called from any
+  // thread.
+  bool TryPush(SpanData&& span_data) noexcept;
+
+  // Returns false if the queue is empty. Must only be called from the consumer
+  // thread.
+  bool TryPop(SpanData& span_data) noexcept;
+
+  // Makes every later push fail. Pushes that had already claimed a cell may
+  // still be filling it after Close returns; see IsDrained.
+  void Close() noexcept;
+
+  // Returns true if the queue is closed and every span pushed before that has
+  // been popped. Must only be called from the consumer thread.
+  bool IsDrained() const noexcept;
+
+  // Returns the approximate number of queued spans.
+  size_t size() const noexcept;
+
+  size_t capacity() const noexcept { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    SpanData span_data;
+  };
+
+  // Keep the positions on separate cache lines so that producers and the
+  // consumer don't invalidate each other's cache.
+  static const size_t CacheLineSize = 64;
+
+  // Set in enqueue_position_ once the queue is closed.
+  static const size_t ClosedFlag = ~(~size_t{0} >> 1);
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  char padding0_[CacheLineSize];
+  std::atomic<size_t> enqueue_position_;
+  char padding1_[CacheLineSize];
+  std::atomic<size_t> dequeue_position_;
+  char padding2_[CacheLineSize];
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_SPAN_QUEUE_H
@@ -0,0 +1,254 @@
+#include "span_spool.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Encoded spans are written to the segment file once they take up this much
+// space.
+static const size_t MaxBufferSize = 64 * 1024;
+
+static const char SegmentPrefix[] = "spool-";
+static const char SegmentSuffix[] = ".bin";
+static const size_t SequenceDigits = 20;
+
+static void MakeDirectory(const std::string& path) {
+#ifdef _WIN32
+  _mkdir(path.c_str());
+#else
+  mkdir(path.c_str(), 0777);
+#endif
+}
+
+static std::vector<std::string> ListDirectory(const std::string& path) {
+  std::vector<std::string> result;
+#ifdef _WIN32
+  WIN32_FIND_DATAA find_data;
+  auto handle = FindFirstFileA((path + "/*").c_str(), &find_data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return result;
+  }
+  do {
+    result.emplace_back(find_data.cFileName);
+  } while (FindNextFileA(handle, &find_data));
+  FindClose(handle);
+#else
+  auto directory = opendir(path.c_str());
+  if (directory == nullptr) {
+    return result;
+  }
+  while (auto entry = readdir(directory)) {
+    result.emplace_back(entry->d_name);
+  }
+  closedir(directory);
+#endif
+  return result;
+}
+
+static void SyncFile(std::FILE* file) {
+#ifdef _WIN32
+  _commit(_fileno(file));
+#else
+  fsync(fileno(file));
+#endif
+}
+
+// Returns true if name is a segment file name, setting sequence to its
+// sequence number.
+static bool ParseSegmentName(const std::string& name, uint64_t& sequence) {
+  auto prefix_size = sizeof(SegmentPrefix) - 1;
+  auto suffix_size = sizeof(SegmentSuffix) - 1;
+  if (name.size() != prefix_size + SequenceDigits + suffix_size ||
+      name.compare(0, prefix_size, SegmentPrefix) != 0 ||
+      name.compare(prefix_size + SequenceDigits, suffix_size, SegmentSuffix) !=
+          0) {
+    return false;
+  }
+  sequence = 0;
+  for (size_t i = prefix_size; i < prefix_size + SequenceDigits; ++i) {
+    if (name[i] < '0' || name[i] > '9') {
+      return false;
+    }
+    sequence = sequence * 10 + static_cast<uint64_t>(name[i] - '0');
+  }
+  return true;
+}
+
+SpanSpool::SpanSpool(const AsyncRecorderOptions& options)
+    : directory_{options.spool_directory},
+      max_segment_size_{options.max_spool_segment_size},
+      max_spool_size_{options.max_spool_size},
+      sync_policy_{options.spool_sync_policy} {
+  MakeDirectory(directory_);
+  RecoverSegments();
+}
+
+SpanSpool::~SpanSpool() {
+  // Unread spans stay in the directory for the next spool to pick up.
+  WriteBuffer();
+  CloseWriteSegment();
+  reader_.reset();
+}
+
+std::string SpanSpool::GetSegmentPath(uint64_t sequence) const {
+  std::string digits(SequenceDigits, '0');
+  for (auto i = digits.rbegin(); sequence != 0; ++i) {
+    *i = static_cast<char>('0' + sequence % 10);
+    sequence /= 10;
+  }
+  return directory_ + "/" + SegmentPrefix + digits + SegmentSuffix;
+}
+
+void SpanSpool::RecoverSegments() {
+  for (auto& name : ListDirectory(directory_)) {
+    Segment segment;
+    if (!ParseSegmentName(name, segment.sequence)) {
+      continue;
+    }
+    std::ifstream in{GetSegmentPath(segment.sequence),
+                     std::ios::binary | std::ios::ate};
+    if (!in) {
+      continue;
+    }
+    segment.size = static_cast<size_t>(in.tellg());
+    segments_.push_back(segment);
+    num_spooled_bytes_ += segment.size;
+  }
+  std::sort(segments_.begin(), segments_.end(),
+            [](const Segment& lhs, const Segment& rhs) {
+              return lhs.sequence < rhs.sequence;
+            });
+  if (!segments_.empty()) {
+    next_sequence_ = segments_.back().sequence + 1;
+  }
+}
+
+bool SpanSpool::OpenWriteSegment() {
+  write_sequence_ = next_sequence_++;
+  write_file_ = std::fopen(GetSegmentPath(write_sequence_).c_str(), "wb");
+  if (write_file_ == nullptr) {
+    return false;
+  }
+  write_file_size_ = 0;
+  encoder_ = SpanEncoder{};
+  buffer_.assign(BinaryHeader, sizeof(BinaryHeader));
+  return true;
+}
+
+bool SpanSpool::WriteBuffer() noexcept {
+  if (write_file_ == nullptr || buffer_.empty()) {
+    return true;
+  }
+  auto num_written =
+      std::fwrite(buffer_.data(), 1, buffer_.size(), write_file_);
+  write_file_size_ += num_written;
+  num_spooled_bytes_ += num_written;
+  auto success = num_written == buffer_.size();
+  buffer_.clear();
+  return success;
+}
+
+void SpanSpool::CloseWriteSegment() noexcept {
+  if (write_file_ == nullptr) {
+    return;
+  }
+  std::fflush(write_file_);
+  if (sync_policy_ != SpoolSyncPolicy::Never) {
+    SyncFile(write_file_);
+  }
+  std::fclose(write_file_);
+  write_file_ = nullptr;
+  segments_.push_back({write_sequence_, write_file_size_});
+}
+
+bool SpanSpool::Write(const SpanData& span_data) noexcept try {
+  if (num_spooled_bytes_ + buffer_.size() >= max_spool_size_) {
+    return false;
+  }
+  if (write_file_ == nullptr && !OpenWriteSegment()) {
+    return false;
+  }
+  encoder_.Encode(span_data, buffer_);
+  if (buffer_.size() >= MaxBufferSize) {
+    return WriteBuffer();
+  }
+  return true;
+} catch (const std::exception& /*e*/) {
+  return false;
+}
+
+void SpanSpool::Flush() noexcept {
+  if (write_file_ == nullptr) {
+    return;
+  }
+  WriteBuffer();
+  std::fflush(write_file_);
+  if (write_file_size_ >= max_segment_size_) {
+    CloseWriteSegment();
+  } else if (sync_policy_ == SpoolSyncPolicy::EveryBatch) {
+    SyncFile(write_file_);
+  }
+}
+
+void SpanSpool::OpenReadSegment() {
+  auto& segment = segments_.front();
+  read_sequence_ = segment.sequence;
+  read_file_size_ = segment.size;
+  segments_.pop_front();
+  read_file_.open(GetSegmentPath(read_sequence_), std::ios::binary);
+  reader_.reset(new BinaryReader{read_file_});
+}
+
+void SpanSpool::CloseReadSegment() noexcept {
+  reader_.reset();
+  read_file_.close();
+  read_file_.clear();
+  std::remove(GetSegmentPath(read_sequence_).c_str());
+  if (num_spooled_bytes_ > read_file_size_) {
+    num_spooled_bytes_ -= read_file_size_;
+  } else {
+    num_spooled_bytes_ = 0;
+  }
+}
+
+bool SpanSpool::Read(SpanData& span_data) noexcept {
+  while (true) {
+    try {
+      if (reader_ == nullptr) {
+        if (segments_.empty()) {
+          // The reader has caught up with the writer, so close the segment
+          // being written to read the rest of the spans.
+          WriteBuffer();
+          CloseWriteSegment();
+          if (segments_.empty()) {
+            num_spooled_bytes_ = 0;
+            return false;
+          }
+        }
+        OpenReadSegment();
+      }
+      if (reader_->Read(span_data)) {
+        return true;
+      }
+    } catch (const std::exception& /*e*/) {
+      // Skip the rest of the segment.
+    }
+    CloseReadSegment();
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,99 @@
+#ifndef OPENTRACING_MOCKTRACER_SPAN_SPOOL_H
+#define OPENTRACING_MOCKTRACER_SPAN_SPOOL_H
+
+#include <opentracing/mocktracer/async_recorder.h>
+#include <opentracing/mocktracer/binary.h>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "binary_encoding.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// SpanSpool is a first-in first-out queue of spans kept in a directory of
+// append-only segment files.
+//
+// Each segment is a stream in the binary format named spool-<sequence>.bin,
+// where sequence is a zero-padded, increasing number. Spans are appended to
+// the newest segment until it reaches the maximum segment size; they're read
+// back from the oldest segment, which is deleted once it has been read. Only
+// the newest segment is ever open for writing, and the reader only opens a
+// segment after it has been closed for writing.
+//
+// Segments left behind by an earlier process are picked up on construction
+// and read before any new spans.
+//
+// SpanSpool isn't thread-safe.
+class SpanSpool {
+ public:
+  // Creates the directory if it doesn't exist.
+  explicit SpanSpool(const AsyncRecorderOptions& options);
+
+  SpanSpool(const SpanSpool&) = delete;
+  SpanSpool& operator=(const SpanSpool&) = delete;
+
+  ~SpanSpool();
+
+  bool empty() const noexcept { return num_spooled_bytes_ == 0; }
+
+  // Appends span_data to the newest segment. Returns false if the span
+  // couldn't be written or the spool is full.
+  bool Write(const SpanData& span_data) noexcept;
+
+  // Writes out the spans appended since the last call, syncing them to disk
+  // if the sync policy is SpoolSyncPolicy::EveryBatch.
+  void Flush() noexcept;
+
+  // Reads the oldest span into span_data. Returns false if the spool is
+  // empty.
+  //
+  // Segments that can't be read, such as one truncated by a crash, are
+  // skipped from the first malformed record on.
+  bool Read(SpanData& span_data) noexcept;
+
+ private:
+  std::string directory_;
+  size_t max_segment_size_;
+  size_t max_spool_size_;
+  SpoolSyncPolicy sync_policy_;
+
+  struct Segment {
+    uint64_t sequence;
+    size_t size;
+  };
+
+  // Segments that are closed for writing, oldest first.
+  std::deque<Segment> segments_;
+  uint64_t next_sequence_ = 0;
+
+  // Bytes in segment files that haven't been fully read yet.
+  size_t num_spooled_bytes_ = 0;
+
+  std::FILE* write_file_ = nullptr;
+  uint64_t write_sequence_ = 0;
+  size_t write_file_size_ = 0;
+  SpanEncoder encoder_;
+  std::string buffer_;
+
+  std::ifstream read_file_;
+  std::unique_ptr<BinaryReader> reader_;
+  uint64_t read_sequence_ = 0;
+  size_t read_file_size_ = 0;
+
+  std::string GetSegmentPath(uint64_t sequence) const;
+  void RecoverSegments();
+  bool OpenWriteSegment();
+  bool WriteBuffer() noexcept;
+  void CloseWriteSegment() noexcept;
+  void OpenReadSegment();
+  void CloseReadSegment() noexcept;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_SPAN_SPOOL_H
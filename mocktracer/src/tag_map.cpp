@@ -0,0 +1,150 @@
+#include <opentracing/mocktracer/tag_map.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// Up to this many tags, finding a tag scans them in the order they were set
+// rather than searching the sorted indices, as comparing key sizes first
+// avoids most key comparisons.
+static const size_t MaxLinearSearchSize = 16;
+
+static bool KeyEqual(const std::string& lhs, string_view rhs) noexcept {
+  return lhs.size() == rhs.size() &&
+         (lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+static bool KeyLess(const std::string& lhs, string_view rhs) noexcept {
+  auto size = std::min(lhs.size(), rhs.size());
+  auto result = size == 0 ? 0 : std::memcmp(lhs.data(), rhs.data(), size);
+  return result < 0 || (result == 0 && lhs.size() < rhs.size());
+}
+
+TagMap::TagMap(std::initializer_list<value_type> tags) {
+  reserve(tags.size());
+  for (auto& tag : tags) {
+    insert_or_assign(tag.first, tag.second);
+  }
+}
+
+void TagMap::reserve(size_t size) {
+  if (size > tags_.capacity()) {
+    Reallocate(size);
+  }
+  order_.reserve(size);
+}
+
+// Returns true if moving value can throw, which is the case for Values and
+// Dictionary, as they're held through a heap-allocated wrapper.
+static bool IsMoveThrowing(const Value& value) noexcept {
+  return value.is<util::recursive_wrapper<Values>>() ||
+         value.is<util::recursive_wrapper<Dictionary>>();
+}
+
+// Value's move constructor isn't noexcept, so std::vector would copy every
+// tag when it reallocates. Most values can't throw when moved, though, so the
+// others are copied into the new vector first and the rest moved once nothing
+// else can fail, which leaves the tags intact if a copy throws.
+void TagMap::Reallocate(size_t capacity) {
+  std::vector<value_type> tags;
+  tags.reserve(capacity);
+  for (auto& tag : tags_) {
+    if (IsMoveThrowing(tag.second)) {
+      tags.push_back(tag);
+    } else {
+      tags.emplace_back();
+    }
+  }
+  for (size_t i = 0; i < tags_.size(); ++i) {
+    if (!IsMoveThrowing(tags_[i].second)) {
+      tags[i] = std::move(tags_[i]);
+    }
+  }
+  tags_.swap(tags);
+}
+
+Value& TagMap::Insert(size_t position, string_view key, Value&& value) {
+  if (tags_.size() == tags_.capacity()) {
+    Reallocate(std::max<size_t>(2 * tags_.size(), 4));
+    order_.reserve(tags_.capacity());
+  }
+  order_.insert(order_.begin() + static_cast<std::ptrdiff_t>(position),
+                static_cast<uint32_t>(tags_.size()));
+  tags_.emplace_back(key, std::move(value));
+  return tags_.back().second;
+}
+
+size_t TagMap::LowerBound(string_view key) const noexcept {
+  auto position =
+      std::lower_bound(order_.begin(), order_.end(), key,
+                       [this](uint32_t index, string_view key) {
+                         return KeyLess(tags_[index].first, key);
+                       });
+  return static_cast<size_t>(position - order_.begin());
+}
+
+const uint32_t* TagMap::Find(string_view key) const noexcept {
+  if (tags_.size() <= MaxLinearSearchSize) {
+    for (size_t i = 0; i < tags_.size(); ++i) {
+      if (KeyEqual(tags_[i].first, key)) {
+        return &*std::find(order_.begin(), order_.end(), i);
+      }
+    }
+    return nullptr;
+  }
+  auto position = LowerBound(key);
+  if (position != order_.size() &&
+      KeyEqual(tags_[order_[position]].first, key)) {
+    return &order_[position];
+  }
+  return nullptr;
+}
+
+TagMap::iterator TagMap::find(string_view key) noexcept {
+  auto position = Find(key);
+  return position != nullptr ? iterator{tags_.data(), position} : end();
+}
+
+TagMap::const_iterator TagMap::find(string_view key) const noexcept {
+  auto position = Find(key);
+  return position != nullptr ? const_iterator{tags_.data(), position} : end();
+}
+
+const Value& TagMap::at(string_view key) const {
+  auto iter = find(key);
+  if (iter == end()) {
+    throw std::out_of_range{"no tag with key " + std::string{key}};
+  }
+  return iter->second;
+}
+
+Value& TagMap::operator[](string_view key) {
+  auto position = Find(key);
+  if (position != nullptr) {
+    return tags_[*position].second;
+  }
+  return Insert(LowerBound(key), key, Value{});
+}
+
+void TagMap::insert_or_assign(string_view key, const Value& value) {
+  auto position = Find(key);
+  if (position != nullptr) {
+    tags_[*position].second = value;
+    return;
+  }
+  Insert(LowerBound(key), key, Value{value});
+}
+
+void TagMap::insert_or_assign(string_view key, Value&& value) {
+  auto position = Find(key);
+  if (position != nullptr) {
+    tags_[*position].second = std::move(value);
+    return;
+  }
+  Insert(LowerBound(key), key, std::move(value));
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,297 @@
+#include <opentracing/ext/tags.h>
+#include <opentracing/mocktracer/tail_sampling_recorder.h>
+#include <algorithm>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+namespace {
+struct TraceOrderEntry {
+  uint64_t trace_id;
+  SteadyTime first_timestamp;
+};
+
+struct BufferedTrace {
+  std::vector<SpanData> spans;
+  std::list<TraceOrderEntry>::iterator order_position;
+};
+
+struct RememberedDecision {
+  uint64_t trace_id = 0;
+  bool is_set = false;
+  bool is_kept = false;
+};
+}  // anonymous namespace
+
+struct TailSamplingRecorder::Shard {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, BufferedTrace> traces;
+
+  // Buffered traces in the order their first span was recorded. A trace's
+  // entry is erased along with the trace when it's decided.
+  std::list<TraceOrderEntry> trace_order;
+  size_t num_spans = 0;
+
+  // Recent decisions, each in the slot its trace id maps to, so that a new
+  // decision replaces whichever was in its slot. Trace ids are divided by the
+  // number of shards first, since the remainder picked the shard.
+  std::vector<RememberedDecision> decisions;
+  size_t num_shards = 1;
+
+  RememberedDecision& DecisionSlot(uint64_t trace_id) {
+    return decisions[(trace_id / num_shards) % decisions.size()];
+  }
+
+  void TakeTrace(std::unordered_map<uint64_t, BufferedTrace>::iterator iter,
+                 std::vector<std::vector<SpanData>>& decided_traces);
+
+  void TakeExpiredTraces(SteadyTime now, size_t max_spans,
+                         SteadyClock::duration decision_timeout,
+                         std::vector<std::vector<SpanData>>& decided_traces);
+};
+
+void TailSamplingRecorder::Shard::TakeTrace(
+    std::unordered_map<uint64_t, BufferedTrace>::iterator iter,
+    std::vector<std::vector<SpanData>>& decided_traces) {
+  num_spans -= iter->second.spans.size();
+  decided_traces.emplace_back(std::move(iter->second.spans));
+  trace_order.erase(iter->second.order_position);
+  traces.erase(iter);
+}
+
+// Takes the traces that timed out, and the oldest traces while the shard is
+// over its share of spans.
+void TailSamplingRecorder::Shard::TakeExpiredTraces(
+    SteadyTime now, size_t max_spans, SteadyClock::duration decision_timeout,
+    std::vector<std::vector<SpanData>>& decided_traces) {
+  while (!trace_order.empty()) {
+    auto& entry = trace_order.front();
+    if (num_spans <= max_spans &&
+        now - entry.first_timestamp < decision_timeout) {
+      return;
+    }
+    TakeTrace(traces.find(entry.trace_id), decided_traces);
+  }
+}
+
+static bool IsLocalRoot(const SpanData& span_data) {
+  return span_data.has_remote_parent ||
+         std::none_of(span_data.references.begin(),
+                      span_data.references.end(),
+                      [](const SpanReferenceData& reference) {
+                        return reference.reference_type ==
+                               SpanReferenceType::ChildOfRef;
+                      });
+}
+
+TailSamplingRecorder::TailSamplingRecorder(
+    std::unique_ptr<Recorder>&& recorder, const TailSamplingOptions& options)
+    : recorder_{std::move(recorder)}, options_(options) {
+  if (options_.num_shards == 0) {
+    options_.num_shards = 1;
+  }
+  max_shard_spans_ =
+      std::max<size_t>(options_.max_buffered_spans / options_.num_shards, 1);
+  auto num_shard_decisions = std::max<size_t>(
+      options_.num_remembered_decisions / options_.num_shards, 1);
+  shards_.reset(new Shard[options_.num_shards]);
+  for (size_t i = 0; i < options_.num_shards; ++i) {
+    shards_[i].num_shards = options_.num_shards;
+    shards_[i].decisions.resize(num_shard_decisions);
+  }
+  if (options_.timeout_check_interval > SteadyClock::duration::zero()) {
+    thread_ = std::thread{&TailSamplingRecorder::Run, this};
+  }
+}
+
+TailSamplingRecorder::~TailSamplingRecorder() { StopThread(); }
+
+void TailSamplingRecorder::RecordSpan(SpanData&& span_data) noexcept try {
+  auto trace_id = span_data.span_context.trace_id;
+  auto is_local_root = IsLocalRoot(span_data);
+  auto now = SteadyClock::now();
+  auto& shard = shards_[trace_id % options_.num_shards];
+  std::vector<std::vector<SpanData>> decided_traces;
+  bool is_late = false;
+  bool is_late_span_kept = false;
+  {
+    std::lock_guard<std::mutex> lock_guard{shard.mutex};
+    auto iter = shard.traces.find(trace_id);
+    if (iter == shard.traces.end()) {
+      auto& decision = shard.DecisionSlot(trace_id);
+      if (decision.is_set && decision.trace_id == trace_id) {
+        // The span's trace was already decided.
+        is_late = true;
+        is_late_span_kept = decision.is_kept;
+      } else {
+        iter = shard.traces.emplace(trace_id, BufferedTrace{}).first;
+        iter->second.order_position =
+            shard.trace_order.insert(shard.trace_order.end(), {trace_id, now});
+      }
+    }
+    if (!is_late) {
+      iter->second.spans.emplace_back(std::move(span_data));
+      ++shard.num_spans;
+      if (is_local_root) {
+        shard.TakeTrace(iter, decided_traces);
+      }
+    }
+    shard.TakeExpiredTraces(now, max_shard_spans_, options_.decision_timeout,
+                            decided_traces);
+  }
+  if (is_late_span_kept && recorder_ != nullptr) {
+    recorder_->RecordSpan(std::move(span_data));
+  }
+  DecideTraces(shard, decided_traces);
+} catch (const std::exception& /*e*/) {
+  // Drop span.
+}
+
+void TailSamplingRecorder::Close() noexcept {
+  StopThread();
+  for (size_t i = 0; i < options_.num_shards; ++i) {
+    auto& shard = shards_[i];
+    std::unordered_map<uint64_t, BufferedTrace> traces;
+    {
+      std::lock_guard<std::mutex> lock_guard{shard.mutex};
+      traces.swap(shard.traces);
+      shard.trace_order.clear();
+      shard.num_spans = 0;
+    }
+    for (auto& trace : traces) {
+      Decide(trace.second.spans);
+    }
+  }
+  if (recorder_ != nullptr) {
+    recorder_->Close();
+  }
+}
+
+void TailSamplingRecorder::Run() noexcept {
+  std::vector<std::vector<SpanData>> decided_traces;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      thread_condition_.wait_for(lock, options_.timeout_check_interval,
+                                 [this] { return is_stopping_; });
+      if (is_stopping_) {
+        return;
+      }
+    }
+    auto now = SteadyClock::now();
+    for (size_t i = 0; i < options_.num_shards; ++i) {
+      auto& shard = shards_[i];
+      try {
+        std::lock_guard<std::mutex> lock_guard{shard.mutex};
+        shard.TakeExpiredTraces(now, max_shard_spans_,
+                                options_.decision_timeout, decided_traces);
+      } catch (const std::exception& /*e*/) {
+        // Try again at the next check.
+      }
+      DecideTraces(shard, decided_traces);
+      decided_traces.clear();
+    }
+  }
+}
+
+void TailSamplingRecorder::StopThread() noexcept {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    is_stopping_ = true;
+    thread.swap(thread_);
+  }
+  thread_condition_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool TailSamplingRecorder::ShouldKeep(
+    const std::vector<SpanData>& spans) const {
+  auto is_latency_checked =
+      options_.latency_threshold > SteadyClock::duration::zero();
+  for (auto& span_data : spans) {
+    if (is_latency_checked &&
+        span_data.duration >= options_.latency_threshold) {
+      return true;
+    }
+    if (options_.keep_errors) {
+      auto iter = span_data.tags.find(ext::error);
+      if (iter != span_data.tags.end() && iter->second == Value{true}) {
+        return true;
+      }
+    }
+    if (std::find(options_.operation_names.begin(),
+                  options_.operation_names.end(),
+                  span_data.operation_name) != options_.operation_names.end()) {
+      return true;
+    }
+  }
+  return options_.keep_trace && options_.keep_trace(spans);
+}
+
+bool TailSamplingRecorder::Decide(std::vector<SpanData>& spans) noexcept {
+  bool is_kept;
+  try {
+    is_kept = ShouldKeep(spans);
+  } catch (const std::exception& /*e*/) {
+    is_kept = false;
+  }
+  if (!is_kept) {
+    num_dropped_traces_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  num_kept_traces_.fetch_add(1, std::memory_order_relaxed);
+  Forward(spans);
+  return true;
+}
+
+void TailSamplingRecorder::DecideTraces(
+    Shard& shard, std::vector<std::vector<SpanData>>& traces) noexcept {
+  std::vector<std::vector<SpanData>> late_traces;
+  for (auto& spans : traces) {
+    if (spans.empty()) {
+      continue;
+    }
+    auto trace_id = spans.front().span_context.trace_id;
+    auto is_kept = Decide(spans);
+    try {
+      std::lock_guard<std::mutex> lock_guard{shard.mutex};
+      auto& decision = shard.DecisionSlot(trace_id);
+      decision.trace_id = trace_id;
+      decision.is_set = true;
+      decision.is_kept = is_kept;
+      // Spans recorded while the trace was being decided were buffered as a
+      // new trace; they follow the decision too.
+      auto late_iter = shard.traces.find(trace_id);
+      if (late_iter != shard.traces.end()) {
+        shard.TakeTrace(late_iter, late_traces);
+      }
+    } catch (const std::exception& /*e*/) {
+      // The decision is forgotten, so later spans are decided on their own.
+    }
+    if (is_kept) {
+      for (auto& late_spans : late_traces) {
+        Forward(late_spans);
+      }
+    }
+    late_traces.clear();
+  }
+}
+
+void TailSamplingRecorder::Forward(std::vector<SpanData>& spans) noexcept {
+  if (recorder_ == nullptr) {
+    return;
+  }
+  for (auto& span_data : spans) {
+    recorder_->RecordSpan(std::move(span_data));
+  }
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
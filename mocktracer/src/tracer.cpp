@@ -1,3 +1,4 @@
+#include <opentracing/ext/tags.h>
 #include <opentracing/mocktracer/tracer.h>
 #include <cstdio>
 #include <exception>
@@ -5,6 +6,8 @@
 #include "mock_span.h"
 #include "mock_span_context.h"
 #include "propagation.h"
+#include "unsampled_span.h"
+#include "utility.h"
 
 #include <opentracing/dynamic_load.h>
 #include <opentracing/mocktracer/tracer_factory.h>
@@ -55,21 +58,130 @@ opentracing::expected<std::unique_ptr<opentracing::SpanContext>> ExtractImpl(
   return std::move(span_context);
 }
 
+// Returns the context of the first span referenced in options, whose trace a
+// new span joins, or nullptr if the new span starts a trace.
+static const MockSpanContext* FindParentContext(
+    const StartSpanOptions& options) {
+  for (auto& reference : options.references) {
+    auto span_context = dynamic_cast<const MockSpanContext*>(reference.second);
+    if (span_context != nullptr) {
+      return span_context;
+    }
+  }
+  return nullptr;
+}
+
+namespace {
+// Maps a sampling.priority tag to the decision it forces: sampled if it's
+// positive, not sampled if it's zero.
+struct SamplingPriorityVisitor {
+  using result_type = SamplingDecision;
+
+  template <class T>
+  SamplingDecision operator()(const T&) const {
+    return SamplingDecision::Undecided;
+  }
+
+  SamplingDecision operator()(bool value) const {
+    return value ? SamplingDecision::Sampled : SamplingDecision::NotSampled;
+  }
+
+  SamplingDecision operator()(double value) const {
+    return value > 0 ? SamplingDecision::Sampled : SamplingDecision::NotSampled;
+  }
+
+  SamplingDecision operator()(int64_t value) const {
+    return value > 0 ? SamplingDecision::Sampled : SamplingDecision::NotSampled;
+  }
+
+  SamplingDecision operator()(uint64_t value) const {
+    return value > 0 ? SamplingDecision::Sampled : SamplingDecision::NotSampled;
+  }
+};
+}  // anonymous namespace
+
+// Returns the decision forced by the last sampling.priority tag in options,
+// or Undecided if there's none.
+static SamplingDecision GetSamplingPriority(const StartSpanOptions& options) {
+  for (auto iter = options.tags.rbegin(); iter != options.tags.rend();
+       ++iter) {
+    if (iter->first == ext::sampling_priority) {
+      SamplingPriorityVisitor visitor;
+      return apply_visitor(visitor, iter->second);
+    }
+  }
+  return SamplingDecision::Undecided;
+}
+
 MockTracer::MockTracer(MockTracerOptions&& options)
     : recorder_{std::move(options.recorder)},
-      propagation_options_{std::move(options.propagation_options)} {}
+      sampler_{std::move(options.sampler)},
+      clock_{std::move(options.clock)},
+      propagation_options_{std::move(options.propagation_options)},
+      span_pool_capacity_{options.span_pool_capacity},
+      thread_safe_spans_{options.thread_safe_spans},
+      spans_own_tracer_{options.spans_own_tracer} {
+  if (!spans_own_tracer_) {
+    live_span_counter_.reset(new LiveSpanCounter{});
+  }
+}
+
+MockTracer::~MockTracer() {
+  if (live_span_counter_ != nullptr) {
+    live_span_counter_->WaitForSpans();
+  }
+}
 
 std::unique_ptr<Span> MockTracer::StartSpanWithOptions(
     string_view operation_name, const StartSpanOptions& options) const
     noexcept try {
-  return std::unique_ptr<Span>{new MockSpan{shared_from_this(), recorder_.get(),
-                                            operation_name, options}};
+  std::shared_ptr<const Tracer> tracer;
+  if (spans_own_tracer_) {
+    tracer = shared_from_this();
+  } else {
+    // Use the aliasing constructor with an empty owner to get a pointer to the
+    // tracer that doesn't touch its reference count.
+    tracer = std::shared_ptr<const Tracer>{std::shared_ptr<const Tracer>{},
+                                           this};
+  }
+
+  auto parent_context = FindParentContext(options);
+  auto trace_id =
+      parent_context != nullptr ? parent_context->trace_id() : GenerateId();
+  if (sampler_ != nullptr) {
+    auto sampling_decision = GetSamplingPriority(options);
+    if (sampling_decision == SamplingDecision::Undecided &&
+        parent_context != nullptr) {
+      sampling_decision = parent_context->sampling_decision();
+    }
+    if (sampling_decision == SamplingDecision::Undecided) {
+      sampling_decision = sampler_->ShouldSample(trace_id, operation_name)
+                              ? SamplingDecision::Sampled
+                              : SamplingDecision::NotSampled;
+    }
+    if (sampling_decision == SamplingDecision::NotSampled) {
+      return std::unique_ptr<Span>{
+          new UnsampledSpan{std::move(tracer), thread_safe_spans_, trace_id,
+                            options}};
+    }
+  }
+
+  std::unique_ptr<Span> span{new (SpanPool{span_pool_capacity_}) MockSpan{
+      std::move(tracer), recorder_.get(), live_span_counter_.get(),
+      clock_.get(), thread_safe_spans_, trace_id, operation_name, options}};
+  if (live_span_counter_ != nullptr) {
+    live_span_counter_->Increment();
+  }
+  return span;
 } catch (const std::exception& e) {
   fprintf(stderr, "Failed to start span: %s\n", e.what());
   return nullptr;
 }
 
 void MockTracer::Close() noexcept {
+  if (live_span_counter_ != nullptr) {
+    live_span_counter_->WaitForSpans();
+  }
   if (recorder_ != nullptr) {
     recorder_->Close();
   }
@@ -1,10 +1,9 @@
+#include <opentracing/mocktracer/file_stream.h>
 #include <opentracing/mocktracer/json_recorder.h>
 #include <opentracing/mocktracer/tracer.h>
 #include <opentracing/mocktracer/tracer_factory.h>
 #include <cctype>
-#include <cerrno>
 #include <cstring>
-#include <fstream>
 #include <stdexcept>
 #include <string>
 
@@ -114,20 +113,15 @@ expected<std::shared_ptr<Tracer>> MockTracerFactory::MakeTracer(
     return make_unexpected(invalid_configuration_error);
   }
 
-  errno = 0;
-  std::unique_ptr<std::ostream> ostream{
-      new std::ofstream{tracer_configuration.output_file}};
-  if (!ostream->good()) {
-    error_message = "failed to open file `";
-    error_message += tracer_configuration.output_file + "` (";
-    error_message += std::strerror(errno);
-    error_message += ")";
+  auto ostream_maybe =
+      MakeFileStream(tracer_configuration.output_file, error_message);
+  if (!ostream_maybe) {
     return make_unexpected(invalid_configuration_error);
   }
 
   MockTracerOptions tracer_options;
   tracer_options.recorder =
-      std::unique_ptr<Recorder>{new JsonRecorder{std::move(ostream)}};
+      std::unique_ptr<Recorder>{new JsonRecorder{std::move(*ostream_maybe)}};
 
   return std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
 } catch (const std::bad_alloc&) {
@@ -0,0 +1,42 @@
+#include "unsampled_span.h"
+#include <cstdio>
+#include "utility.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+UnsampledSpan::UnsampledSpan(std::shared_ptr<const Tracer>&& tracer,
+                             bool thread_safe, uint64_t trace_id,
+                             const StartSpanOptions& options)
+    : tracer_{std::move(tracer)}, span_context_{thread_safe} {
+  std::shared_ptr<const BaggageMap> baggage;
+  for (auto& reference : options.references) {
+    auto referenced_context =
+        dynamic_cast<const MockSpanContext*>(reference.second);
+    if (referenced_context != nullptr) {
+      MergeBaggage(*referenced_context, baggage);
+    }
+  }
+  span_context_ = MockSpanContext{trace_id, GenerateId(), std::move(baggage),
+                                  SamplingDecision::NotSampled};
+}
+
+void UnsampledSpan::SetBaggageItem(string_view restricted_key,
+                                   string_view value) noexcept try {
+  span_context_.SetBaggageItem(restricted_key, value);
+} catch (const std::exception& e) {
+  // Drop baggage item upon error.
+  fprintf(stderr, "Failed to set baggage item: %s\n", e.what());
+}
+
+std::string UnsampledSpan::BaggageItem(string_view restricted_key) const
+    noexcept try {
+  return span_context_.BaggageItem(restricted_key);
+} catch (const std::exception& e) {
+  // Return empty string upon error.
+  fprintf(stderr, "Failed to retrieve baggage item: %s\n", e.what());
+  return {};
+}
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,62 @@
+#ifndef OPENTRACING_MOCKTRACER_UNSAMPLED_SPAN_H
+#define OPENTRACING_MOCKTRACER_UNSAMPLED_SPAN_H
+
+#include <opentracing/mocktracer/tracer.h>
+#include "mock_span_context.h"
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace mocktracer {
+// UnsampledSpan is started instead of a MockSpan for a trace that isn't
+// sampled. It only keeps the ids needed for spans started from its context to
+// inherit the decision, and its baggage, which is propagated whether or not
+// the trace is sampled. Its operation name, tags and logs are ignored.
+//
+// Like a MockSpan's, its baggage is shared with the contexts it references
+// until a baggage item is set.
+class UnsampledSpan : public Span {
+ public:
+  UnsampledSpan(std::shared_ptr<const Tracer>&& tracer, bool thread_safe,
+                uint64_t trace_id, const StartSpanOptions& options);
+
+  void FinishWithOptions(
+      const FinishSpanOptions& /*options*/) noexcept override {}
+
+  void SetOperationName(string_view /*name*/) noexcept override {}
+
+  void SetTag(string_view /*key*/,
+              const opentracing::Value& /*value*/) noexcept override {}
+
+  void Log(std::initializer_list<std::pair<string_view, Value>>
+           /*fields*/) noexcept override {}
+
+  void Log(SystemTime /*timestamp*/,
+           std::initializer_list<std::pair<string_view, Value>>
+           /*fields*/) noexcept override {}
+
+  void Log(SystemTime /*timestamp*/,
+           const std::vector<std::pair<string_view, Value>>&
+           /*fields*/) noexcept override {}
+
+  void SetBaggageItem(string_view restricted_key,
+                      string_view value) noexcept override;
+
+  std::string BaggageItem(string_view restricted_key) const noexcept override;
+
+  const SpanContext& context() const noexcept override { return span_context_; }
+
+  const opentracing::Tracer& tracer() const noexcept override {
+    return *tracer_;
+  }
+
+  bool IsRecording() const noexcept override { return false; }
+
+ private:
+  std::shared_ptr<const Tracer> tracer_;
+  MockSpanContext span_context_;
+};
+}  // namespace mocktracer
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
+
+#endif  // OPENTRACING_MOCKTRACER_UNSAMPLED_SPAN_H
@@ -1,5 +1,8 @@
 #include "utility.h"
 #include <climits>
+#include <functional>
+#include <random>
+#include <thread>
 
 namespace opentracing {
 BEGIN_OPENTRACING_ABI_NAMESPACE
@@ -52,6 +55,17 @@ uint32_t SwapEndianIfBig(uint32_t x) {
     return x;
   }
 }
+
+uint64_t GenerateId() {
+  static thread_local std::mt19937_64 rand_source{std::random_device()()};
+  return static_cast<uint64_t>(rand_source());
+}
+
+size_t GetThreadIndex() noexcept {
+  static thread_local size_t index =
+      std::hash<std::thread::id>{}(std::this_thread::get_id());
+  return index;
+}
 }  // namespace mocktracer
 END_OPENTRACING_ABI_NAMESPACE
 }  // namespace opentracing
@@ -2,6 +2,7 @@
 #define OPENTRACING_MOCKTRACER_UTILITY_H
 
 #include <opentracing/mocktracer/tracer.h>
+#include <cstddef>
 #include <cstdint>
 
 namespace opentracing {
@@ -10,6 +11,13 @@ namespace mocktracer {
 // If the native architecture is big endian, swaps the endianness of x
 uint64_t SwapEndianIfBig(uint64_t x);
 uint32_t SwapEndianIfBig(uint32_t x);
+
+// Returns a random trace or span id.
+uint64_t GenerateId();
+
+// Returns a number identifying the calling thread, for spreading threads
+// over sharded counters.
+size_t GetThreadIndex() noexcept;
 }  // namespace mocktracer
 END_OPENTRACING_ABI_NAMESPACE
 }  // namespace opentracing
@@ -0,0 +1,163 @@
+#include <opentracing/mocktracer/binary.h>
+#include <opentracing/mocktracer/binary_recorder.h>
+#include <opentracing/mocktracer/json.h>
+#include <opentracing/mocktracer/tracer.h>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+using namespace opentracing;
+using namespace mocktracer;
+
+static std::vector<SpanData> MakeSpans() {
+  SpanData span_data1;
+  span_data1.span_context.trace_id = 0xfedcba9876543210;
+  span_data1.span_context.span_id = 1;
+  span_data1.span_context.baggage = {{"b1", "v1"}, {"b2", ""}};
+  span_data1.operation_name = "o1";
+  span_data1.start_timestamp =
+      SystemTime{} + std::chrono::hours{51} + std::chrono::nanoseconds{7};
+  span_data1.duration = std::chrono::microseconds{92};
+  span_data1.tags = {{"t1", 123},
+                     {"t2", std::string{"cat"}},
+                     {"t3", -1.5},
+                     {"t4", std::numeric_limits<uint64_t>::max()},
+                     {"t5", true},
+                     {"t6", nullptr},
+                     {"t7", Values{false, std::string{"x"}, Values{}}},
+                     {"t8", Dictionary{{"k", std::string{"v"}}}}};
+  span_data1.logs = {
+      {span_data1.start_timestamp, {{"l1", 1}, {"t1", 1.5}}},
+      {span_data1.start_timestamp - std::chrono::seconds{1}, {}}};
+
+  // The second span reuses strings from the first and starts before it.
+  SpanData span_data2;
+  span_data2.span_context.trace_id = 0xfedcba9876543210;
+  span_data2.span_context.span_id = 2;
+  span_data2.references = {
+      {SpanReferenceType::ChildOfRef, 0xfedcba9876543210, 1},
+      {SpanReferenceType::FollowsFromRef, 3, 4}};
+  span_data2.operation_name = "o1";
+  span_data2.start_timestamp =
+      span_data1.start_timestamp - std::chrono::milliseconds{3};
+  span_data2.duration = std::chrono::nanoseconds{0};
+  span_data2.tags = {{"t1", -123}, {"b1", std::string{"dog"}}};
+
+  SpanData span_data3;
+  span_data3.span_context.trace_id = 0;
+  span_data3.span_context.span_id = 0;
+  span_data3.duration = std::chrono::nanoseconds{0};
+
+  return {span_data1, span_data2, span_data3};
+}
+
+TEST_CASE("binary") {
+  auto spans = MakeSpans();
+  std::ostringstream oss;
+  ToBinary(oss, spans);
+  auto serialization = oss.str();
+
+  SECTION("Spans are read back unchanged.") {
+    std::istringstream iss{serialization};
+    BinaryReader reader{iss};
+    SpanData span_data;
+    for (auto& expected_span_data : spans) {
+      REQUIRE(reader.Read(span_data));
+      CHECK(span_data == expected_span_data);
+    }
+    CHECK(!reader.Read(span_data));
+  }
+
+  SECTION("Binary spans convert to the same JSON as ToJson.") {
+    std::istringstream iss{serialization};
+    std::ostringstream json;
+    BinaryToJson(iss, json);
+    std::ostringstream expected_json;
+    ToJson(expected_json, spans);
+    CHECK(json.str() == expected_json.str());
+  }
+
+  SECTION("Lazy values are written as the value they compute.") {
+    auto span_data = spans[1];
+    span_data.lazy_tags = {
+        {"lazy", LazyValue{[] { return Value{std::string{"computed"}}; }}}};
+    std::ostringstream oss;
+    ToBinary(oss, {span_data});
+    std::istringstream iss{oss.str()};
+    BinaryReader reader{iss};
+    REQUIRE(reader.Read(span_data));
+    CHECK(span_data.tags.find("lazy")->second ==
+          Value{std::string{"computed"}});
+  }
+
+  SECTION("Repeated strings are written once.") {
+    std::ostringstream oss;
+    ToBinary(oss, {spans[0], spans[0]});
+    CHECK(oss.str().find("o1") == oss.str().rfind("o1"));
+  }
+
+  SECTION("An empty stream has no spans.") {
+    std::istringstream iss;
+    BinaryReader reader{iss};
+    SpanData span_data;
+    CHECK(!reader.Read(span_data));
+  }
+
+  SECTION("Input that isn't in the binary format is rejected.") {
+    std::istringstream iss{"[{}]"};
+    BinaryReader reader{iss};
+    SpanData span_data;
+    CHECK_THROWS_AS(reader.Read(span_data), std::runtime_error);
+  }
+
+  SECTION("Truncated input is rejected.") {
+    std::ostringstream oss1, oss2;
+    ToBinary(oss1, {spans[0]});
+    ToBinary(oss2, {spans[0], spans[1]});
+    for (size_t size = 6; size < serialization.size(); ++size) {
+      std::istringstream iss{serialization.substr(0, size)};
+      BinaryReader reader{iss};
+      SpanData span_data;
+      bool threw = false;
+      try {
+        while (reader.Read(span_data)) {
+        }
+      } catch (const std::runtime_error&) {
+        threw = true;
+      }
+      // Truncating at a record boundary reads fewer spans without error.
+      CHECK(threw != (size == oss1.str().size() || size == oss2.str().size()));
+    }
+  }
+}
+
+TEST_CASE("binary_recorder") {
+  auto oss = new std::ostringstream{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder = std::unique_ptr<Recorder>{
+      new BinaryRecorder{std::unique_ptr<std::ostream>{oss}}};
+  auto tracer =
+      std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Spans are serialized to the stream upon Close.") {
+    auto span_a = tracer->StartSpan("a");
+    auto span_b = tracer->StartSpan("b", {ChildOf(&span_a->context())});
+    span_b->SetTag("abc", 123);
+    span_b->Finish();
+    span_a->Finish();
+    tracer->Close();
+
+    std::istringstream iss{oss->str()};
+    BinaryReader reader{iss};
+    SpanData span_data;
+    REQUIRE(reader.Read(span_data));
+    CHECK(span_data.operation_name == "b");
+    CHECK(span_data.tags == TagMap{{"abc", 123}});
+    CHECK(span_data.references.size() == 1);
+    REQUIRE(reader.Read(span_data));
+    CHECK(span_data.operation_name == "a");
+    CHECK(!reader.Read(span_data));
+  }
+}
@@ -0,0 +1,138 @@
+#include <opentracing/mocktracer/flight_recorder.h>
+#include <opentracing/mocktracer/tracer.h>
+#include <cstdio>
+#include <fstream>
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+using namespace opentracing;
+using namespace mocktracer;
+
+#ifdef _WIN32
+TEST_CASE("flight_recorder") {
+  FlightRecorderOptions options;
+  options.path = "flight_recorder_test.rec";
+  std::string error_message;
+  CHECK(!MakeFlightRecorder(options, error_message));
+}
+#else
+static SpanData MakeSpan(int i) {
+  SpanData span_data;
+  span_data.span_context.trace_id = 1;
+  span_data.span_context.span_id = static_cast<uint64_t>(i);
+  span_data.operation_name = "span" + std::to_string(i);
+  span_data.duration = std::chrono::microseconds{i};
+  span_data.tags = {{"i", i}};
+  return span_data;
+}
+
+static std::vector<SpanData> Read(const std::string& path) {
+  std::string error_message;
+  auto spans = ReadFlightRecording(path, error_message);
+  REQUIRE(spans);
+  return *spans;
+}
+
+TEST_CASE("flight_recorder") {
+  const std::string path = "flight_recorder_test.rec";
+  std::remove(path.c_str());
+  FlightRecorderOptions options;
+  options.path = path;
+  options.ring_size = 4096;
+  std::string error_message;
+  auto recorder = MakeFlightRecorder(options, error_message);
+  REQUIRE(recorder);
+
+  SECTION("Recorded spans are read back in order.") {
+    for (int i = 0; i < 3; ++i) {
+      (*recorder)->RecordSpan(MakeSpan(i));
+    }
+    auto spans = Read(path);
+    REQUIRE(spans.size() == 3);
+    for (int i = 0; i < 3; ++i) {
+      CHECK(spans[i] == MakeSpan(i));
+    }
+  }
+
+  SECTION("Only the most recent spans are kept once the ring wraps around.") {
+    const int num_spans = 1000;
+    for (int i = 0; i < num_spans; ++i) {
+      (*recorder)->RecordSpan(MakeSpan(i));
+    }
+    auto spans = Read(path);
+    REQUIRE(!spans.empty());
+    CHECK(spans.size() < num_spans);
+    auto first = num_spans - static_cast<int>(spans.size());
+    for (size_t i = 0; i < spans.size(); ++i) {
+      CHECK(spans[i] == MakeSpan(first + static_cast<int>(i)));
+    }
+  }
+
+  SECTION("Spans are appended to an existing recording.") {
+    (*recorder)->RecordSpan(MakeSpan(0));
+    recorder->reset();
+    recorder = MakeFlightRecorder(options, error_message);
+    REQUIRE(recorder);
+    (*recorder)->RecordSpan(MakeSpan(1));
+    auto spans = Read(path);
+    REQUIRE(spans.size() == 2);
+    CHECK(spans[0] == MakeSpan(0));
+    CHECK(spans[1] == MakeSpan(1));
+  }
+
+  SECTION("Files that aren't flight recordings aren't overwritten.") {
+    recorder->reset();
+    std::ofstream{path} << "abc";
+    CHECK(!MakeFlightRecorder(options, error_message));
+    CHECK(!error_message.empty());
+    std::ifstream file{path};
+    std::string contents{std::istreambuf_iterator<char>{file},
+                         std::istreambuf_iterator<char>{}};
+    CHECK(contents == "abc");
+  }
+
+  SECTION("Recordings with a different ring size aren't overwritten.") {
+    (*recorder)->RecordSpan(MakeSpan(0));
+    recorder->reset();
+    options.ring_size = 8192;
+    CHECK(!MakeFlightRecorder(options, error_message));
+    auto spans = Read(path);
+    REQUIRE(spans.size() == 1);
+    CHECK(spans[0] == MakeSpan(0));
+  }
+
+  SECTION("Corrupt records are skipped.") {
+    for (int i = 0; i < 3; ++i) {
+      (*recorder)->RecordSpan(MakeSpan(i));
+    }
+    recorder->reset();
+    auto spans = Read(path);
+    REQUIRE(spans.size() == 3);
+
+    // Overwrite the last byte of the second span's operation name.
+    std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+    std::string contents{std::istreambuf_iterator<char>{file},
+                         std::istreambuf_iterator<char>{}};
+    auto position = contents.find("span1");
+    REQUIRE(position != std::string::npos);
+    file.seekp(static_cast<std::streamoff>(position + 4));
+    file.put('9');
+    file.close();
+
+    spans = Read(path);
+    REQUIRE(spans.size() == 2);
+    CHECK(spans[0] == MakeSpan(0));
+    CHECK(spans[1] == MakeSpan(2));
+  }
+
+  SECTION("Files that aren't flight recordings are rejected.") {
+    recorder->reset();
+    std::ofstream{path} << "abc";
+    CHECK(!ReadFlightRecording(path, error_message));
+    CHECK(!error_message.empty());
+  }
+
+  recorder->reset();
+  std::remove(path.c_str());
+}
+#endif
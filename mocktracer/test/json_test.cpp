@@ -3,6 +3,11 @@
 #include <opentracing/mocktracer/tracer.h>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
 
 #define CATCH_CONFIG_MAIN
 #include <opentracing/catch2/catch.hpp>
@@ -74,3 +79,121 @@ TEST_CASE("json") {
 
   CHECK(oss.str() == expected_serialization);
 }
+
+TEST_CASE("json values") {
+  SpanData span_data;
+  span_data.span_context.trace_id = 0xfedcba9876543210;
+  span_data.span_context.span_id = 1;
+  span_data.duration = SteadyClock::duration{0};
+  span_data.operation_name = "a\"b\\c\b\n\r\t\x01\x1f\x7f\xc3\xa9";
+  span_data.tags = {{"int_min", std::numeric_limits<int64_t>::min()},
+                    {"int_neg", -42},
+                    {"uint_max", std::numeric_limits<uint64_t>::max()},
+                    {"d1", 0.1},
+                    {"d2", 1e20},
+                    {"d3", -2.5e-7},
+                    {"d4", 123456789.0},
+                    {"nan", std::nan("")},
+                    {"inf", -std::numeric_limits<double>::infinity()},
+                    {"values", Values{true, nullptr, 10}}};
+  span_data.lazy_tags = {
+      {"lazy", LazyValue{[] { return Value{Values{1, "x"}}; }}}};
+  std::ostringstream oss;
+  ToJson(oss, {span_data});
+
+  std::string expected_serialization =
+      R"([{"span_context":{"trace_id":"fedcba9876543210",)"
+      R"("span_id":"0000000000000001","baggage":{}},"references":[],)"
+      R"("operation_name":"a\"b\\c\b\n\r\t\u0001\u001f)"
+      "\x7f\xc3\xa9"
+      R"(","start_timestamp":0,"duration":0,"tags":{"d1":0.1,"d2":1e+20,)"
+      R"("d3":-2.5e-07,"d4":1.23457e+08,"inf":"-Inf",)"
+      R"("int_min":-9223372036854775808,"int_neg":-42,"lazy":[1,"x"],)"
+      R"("nan":"NaN",)"
+      R"("uint_max":18446744073709551615,"values":[true,null,10]},)"
+      R"("logs":[]}])";
+  CHECK(oss.str() == expected_serialization);
+}
+
+// The escaping used by ToJson before it was vectorized.
+static std::string ReferenceEscapedString(const std::string& s) {
+  std::ostringstream writer;
+  writer << '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        writer << R"(\")";
+        break;
+      case '\\':
+        writer << R"(\\)";
+        break;
+      case '\b':
+        writer << R"(\b)";
+        break;
+      case '\n':
+        writer << R"(\n)";
+        break;
+      case '\r':
+        writer << R"(\r)";
+        break;
+      case '\t':
+        writer << R"(\t)";
+        break;
+      default:
+        if ('\x00' <= c && c <= '\x1f') {
+          writer << R"(\u)";
+          writer << std::hex << std::setw(4) << std::setfill('0')
+                 << static_cast<int>(c);
+        } else {
+          writer << c;
+        }
+    }
+  }
+  writer << '"';
+  return writer.str();
+}
+
+TEST_CASE("json string escaping") {
+  SpanData span_data;
+  span_data.duration = SteadyClock::duration{0};
+  std::ostringstream oss;
+  ToJson(oss, {span_data});
+  auto empty_serialization = oss.str();
+  auto name_position = empty_serialization.find(R"("operation_name":"")") +
+                       std::string{R"("operation_name":)"}.size();
+
+  auto check_escaping = [&](const std::string& s) {
+    span_data.operation_name = s;
+    std::ostringstream oss;
+    ToJson(oss, {span_data});
+    auto expected_serialization = empty_serialization;
+    expected_serialization.replace(name_position, 2,
+                                   ReferenceEscapedString(s));
+    CHECK(oss.str() == expected_serialization);
+  };
+
+  SECTION("Every byte is escaped the same way at every position.") {
+    for (int c = 0; c < 256; ++c) {
+      for (size_t position : {0, 1, 15, 16, 17, 31, 40}) {
+        std::string s(41, 'a');
+        s[position] = static_cast<char>(c);
+        check_escaping(s);
+      }
+    }
+  }
+
+  SECTION("Random strings are escaped the same way.") {
+    std::mt19937 random_number_generator{0};
+    const char alphabet[] = "ab\"\\\b\n\r\t\x01\x1f\x20\x7f\x80\xff";
+    std::uniform_int_distribution<size_t> character_distribution{
+        0, sizeof(alphabet) - 2};
+    std::uniform_int_distribution<size_t> length_distribution{0, 100};
+    for (int i = 0; i < 1000; ++i) {
+      std::string s(length_distribution(random_number_generator), ' ');
+      for (auto& c : s) {
+        c = alphabet[character_distribution(random_number_generator)];
+      }
+      check_escaping(s);
+    }
+  }
+}
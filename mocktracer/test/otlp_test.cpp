@@ -0,0 +1,182 @@
+#include <opentracing/mocktracer/otlp.h>
+#include <opentracing/mocktracer/otlp_recorder.h>
+#include <opentracing/mocktracer/tracer.h>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+using namespace opentracing;
+using namespace mocktracer;
+
+static std::string Bytes(std::initializer_list<int> bytes) {
+  std::string result;
+  for (auto byte : bytes) {
+    result.push_back(static_cast<char>(byte));
+  }
+  return result;
+}
+
+static SpanData MakeSpan() {
+  SpanData span_data;
+  span_data.span_context.trace_id = 0x0102030405060708;
+  span_data.span_context.span_id = 0x1112131415161718;
+  span_data.span_context.baggage = {{"b", "v"}};
+  span_data.references = {
+      {SpanReferenceType::ChildOfRef, 0x0102030405060708, 0x2122232425262728},
+      {SpanReferenceType::FollowsFromRef, 9, 10}};
+  span_data.operation_name = "op";
+  span_data.start_timestamp = SystemTime{} + std::chrono::seconds{1};
+  span_data.duration = std::chrono::microseconds{2};
+  span_data.tags = {{"span.kind", "client"},
+                    {"error", true},
+                    {"i", -1},
+                    {"d", 0.5},
+                    {"s", "x"},
+                    {"n", nullptr},
+                    {"a", Values{1, false}},
+                    {"m", Dictionary{{"k", 2}}}};
+  span_data.logs = {{span_data.start_timestamp, {{"event", "e"}, {"f", 3}}}};
+  return span_data;
+}
+
+TEST_CASE("otlp") {
+  SECTION("Spans are encoded as TracesData.") {
+    // The expected bytes can be checked against the published schema with
+    // protoc --decode=opentelemetry.proto.trace.v1.TracesData, and are the
+    // same bytes that protoc --encode produces for the decoded message.
+    auto expected_serialization = Bytes({
+        // TracesData.resource_spans
+        0x0a, 0xa2, 0x02,
+        // ResourceSpans.resource
+        0x0a, 0x17,
+        // Resource.attributes {key: "service.name" value {string_value:
+        // "svc"}}
+        0x0a, 0x15, 0x0a, 0x0c, 's', 'e', 'r', 'v', 'i', 'c', 'e', '.', 'n',
+        'a', 'm', 'e', 0x12, 0x05, 0x0a, 0x03, 's', 'v', 'c',
+        // ResourceSpans.scope_spans
+        0x12, 0x86, 0x02,
+        // ScopeSpans.scope {name: "mocktracer"}
+        0x0a, 0x0c, 0x0a, 0x0a, 'm', 'o', 'c', 'k', 't', 'r', 'a', 'c', 'e',
+        'r',
+        // ScopeSpans.spans
+        0x12, 0xf5, 0x01,
+        // Span.trace_id
+        0x0a, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+        0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        // Span.span_id
+        0x12, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        // Span.parent_span_id
+        0x22, 0x08, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+        // Span.name
+        0x2a, 0x02, 'o', 'p',
+        // Span.kind: SPAN_KIND_CLIENT
+        0x30, 0x03,
+        // Span.start_time_unix_nano
+        0x39, 0x00, 0xca, 0x9a, 0x3b, 0x00, 0x00, 0x00, 0x00,
+        // Span.end_time_unix_nano
+        0x41, 0xd0, 0xd1, 0x9a, 0x3b, 0x00, 0x00, 0x00, 0x00,
+        // Span.attributes {key: "a" value {array_value {values {int_value: 1}
+        // values {bool_value: false}}}}
+        0x4a, 0x0f, 0x0a, 0x01, 'a', 0x12, 0x0a, 0x2a, 0x08, 0x0a, 0x02, 0x18,
+        0x01, 0x0a, 0x02, 0x10, 0x00,
+        // Span.attributes {key: "d" value {double_value: 0.5}}
+        0x4a, 0x0e, 0x0a, 0x01, 'd', 0x12, 0x09, 0x21, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0xe0, 0x3f,
+        // Span.attributes {key: "i" value {int_value: -1}}
+        0x4a, 0x10, 0x0a, 0x01, 'i', 0x12, 0x0b, 0x18, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        // Span.attributes {key: "m" value {kvlist_value {values {key: "k"
+        // value {int_value: 2}}}}}
+        0x4a, 0x10, 0x0a, 0x01, 'm', 0x12, 0x0b, 0x32, 0x09, 0x0a, 0x07, 0x0a,
+        0x01, 'k', 0x12, 0x02, 0x18, 0x02,
+        // Span.attributes {key: "n" value {}}
+        0x4a, 0x05, 0x0a, 0x01, 'n', 0x12, 0x00,
+        // Span.attributes {key: "s" value {string_value: "x"}}
+        0x4a, 0x08, 0x0a, 0x01, 's', 0x12, 0x03, 0x0a, 0x01, 'x',
+        // Span.events {time_unix_nano: 1000000000 name: "e" attributes {key:
+        // "f" value {int_value: 3}}}
+        0x5a, 0x15, 0x09, 0x00, 0xca, 0x9a, 0x3b, 0x00, 0x00, 0x00, 0x00, 0x12,
+        0x01, 'e', 0x1a, 0x07, 0x0a, 0x01, 'f', 0x12, 0x02, 0x18, 0x03,
+        // Span.links {trace_id span_id attributes {key: "opentracing.ref_type"
+        // value {string_value: "follows_from"}}}
+        0x6a, 0x44, 0x0a, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x12, 0x08, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x22, 0x26, 0x0a, 0x14, 'o', 'p',
+        'e', 'n', 't', 'r', 'a', 'c', 'i', 'n', 'g', '.', 'r', 'e', 'f', '_',
+        't', 'y', 'p', 'e', 0x12, 0x0e, 0x0a, 0x0c, 'f', 'o', 'l', 'l', 'o',
+        'w', 's', '_', 'f', 'r', 'o', 'm',
+        // Span.status {code: STATUS_CODE_ERROR}
+        0x7a, 0x02, 0x18, 0x02});
+
+    OtlpOptions options;
+    options.service_name = "svc";
+    std::ostringstream oss;
+    ToOtlp(oss, {MakeSpan()}, options);
+    CHECK(oss.str() == expected_serialization);
+  }
+
+  SECTION("Spans without a parent, kind or status omit those fields.") {
+    SpanData span_data;
+    span_data.span_context.trace_id = 1;
+    span_data.span_context.span_id = 2;
+    span_data.operation_name = "op";
+    span_data.duration = SteadyClock::duration{0};
+    span_data.tags = {{"u", std::numeric_limits<uint64_t>::max()}};
+
+    auto expected_span = Bytes({
+        // Span.trace_id
+        0x0a, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        // Span.span_id
+        0x12, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+        // Span.name
+        0x2a, 0x02, 'o', 'p',
+        // Span.kind: SPAN_KIND_INTERNAL
+        0x30, 0x01,
+        // Span.start_time_unix_nano
+        0x39, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        // Span.end_time_unix_nano
+        0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        // Span.attributes {key: "u" value {string_value:
+        // "18446744073709551615"}}
+        0x4a, 0x1b, 0x0a, 0x01, 'u', 0x12, 0x16, 0x0a, 0x14, '1', '8', '4',
+        '4', '6', '7', '4', '4', '0', '7', '3', '7', '0', '9', '5', '5', '1',
+        '6', '1', '5'});
+    std::ostringstream oss;
+    ToOtlp(oss, {span_data});
+    auto serialization = oss.str();
+    CHECK(serialization.size() >= expected_span.size());
+    CHECK(serialization.substr(serialization.size() - expected_span.size()) ==
+          expected_span);
+  }
+}
+
+TEST_CASE("otlp_recorder") {
+  auto oss = new std::ostringstream{};
+  OtlpOptions options;
+  options.max_buffered_spans = 2;
+  std::unique_ptr<Recorder> recorder{
+      new OtlpRecorder{std::unique_ptr<std::ostream>{oss}, options}};
+
+  SECTION("Batches of spans are written as separate ResourceSpans.") {
+    auto span_data1 = MakeSpan();
+    auto span_data2 = MakeSpan();
+    span_data2.span_context.span_id = 2;
+    auto span_data3 = MakeSpan();
+    span_data3.span_context.span_id = 3;
+
+    recorder->RecordSpan(SpanData{span_data1});
+    CHECK(oss->str().empty());
+    recorder->RecordSpan(SpanData{span_data2});
+    CHECK(!oss->str().empty());
+    recorder->RecordSpan(SpanData{span_data3});
+    recorder->Close();
+
+    std::ostringstream expected_serialization;
+    ToOtlp(expected_serialization, {span_data1, span_data2}, options);
+    ToOtlp(expected_serialization, {span_data3}, options);
+    CHECK(oss->str() == expected_serialization.str());
+  }
+}
@@ -1,5 +1,8 @@
+#include <opentracing/mocktracer/file_stream.h>
 #include <opentracing/mocktracer/tracer_factory.h>
 #include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <random>
 #include <string>
 
@@ -63,6 +66,62 @@ TEST_CASE("tracer_factory") {
         tracer_factory.MakeTracer(configuration.c_str(), error_message);
     REQUIRE(tracer_maybe);
 
+    auto tracer = std::move(*tracer_maybe);
+    tracer->StartSpan("a")->Finish();
+    tracer->Close();
+    std::ifstream in{span_filename};
+    std::string json{std::istreambuf_iterator<char>{in},
+                     std::istreambuf_iterator<char>{}};
+    CHECK(json.find(R"("operation_name":"a")") != std::string::npos);
+
     std::remove(span_filename.c_str());
   }
 }
+
+TEST_CASE("file_stream") {
+  std::string error_message;
+
+  SECTION("Opening a file in a missing directory yields an error.") {
+    auto out_maybe =
+        MakeFileStream("missing_directory/spans.json", error_message);
+    REQUIRE(!out_maybe);
+    CHECK(!error_message.empty());
+  }
+
+  SECTION("Everything written reaches the file once the stream is flushed.") {
+    std::string filename{"file_stream."};
+    filename.append(std::to_string(std::random_device{}()));
+    auto out_maybe = MakeFileStream(filename, error_message);
+    REQUIRE(out_maybe);
+    auto& out = **out_maybe;
+    std::string expected;
+    for (int i = 0; i < 200000; ++i) {
+      auto line = std::to_string(i) + "\n";
+      out << line;
+      expected += line;
+      if (i % 1000 == 0) {
+        out.flush();
+      }
+    }
+    out.flush();
+    CHECK(out.good());
+
+    std::ifstream in{filename};
+    std::string contents{std::istreambuf_iterator<char>{in},
+                         std::istreambuf_iterator<char>{}};
+    CHECK(contents == expected);
+    out_maybe->reset();
+    std::remove(filename.c_str());
+  }
+
+#ifdef __linux__
+  SECTION("Failed writes are reported by the next flush.") {
+    auto out_maybe = MakeFileStream("/dev/full", error_message);
+    REQUIRE(out_maybe);
+    auto& out = **out_maybe;
+    out << "abc";
+    out.flush();
+    CHECK(out.bad());
+  }
+#endif
+}
@@ -1,9 +1,37 @@
+#include <opentracing/ext/tags.h>
+#include <opentracing/mocktracer/adaptive_sampler.h>
+#include <opentracing/mocktracer/async_recorder.h>
+#include <opentracing/mocktracer/binary.h>
 #include <opentracing/mocktracer/in_memory_recorder.h>
 #include <opentracing/mocktracer/json.h>
 #include <opentracing/mocktracer/json_recorder.h>
+#include <opentracing/mocktracer/tail_sampling_recorder.h>
 #include <opentracing/mocktracer/tracer.h>
 #include <opentracing/noop.h>
+#include <opentracing/task_context.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
 
 #define CATCH_CONFIG_MAIN
 #include <opentracing/catch2/catch.hpp>
@@ -23,6 +51,12 @@ TEST_CASE("tracer") {
     auto span = norecorder_tracer->StartSpan("a");
   }
 
+  SECTION("Spans are recording when there's no sampler.") {
+    auto span = tracer->StartSpan("a");
+    CHECK(span->IsRecording());
+    CHECK(span->context().IsSampled());
+  }
+
   SECTION("StartSpan applies the provided tags.") {
     {
       auto span =
@@ -32,7 +66,7 @@ TEST_CASE("tracer") {
     }
     auto span = recorder->top();
     CHECK(span.operation_name == "a");
-    std::map<std::string, Value> expected_tags = {{"abc", 123}, {"xyz", true}};
+    TagMap expected_tags = {{"abc", 123}, {"xyz", true}};
     CHECK(span.tags == expected_tags);
   }
 
@@ -140,7 +174,7 @@ TEST_CASE("tracer") {
     }
     auto span = recorder->top();
     CHECK(span.operation_name == "a");
-    CHECK(span.logs == logs);
+    CHECK((span.logs == std::vector<LogRecord>{logs.begin(), logs.end()}));
   }
 
   SECTION("Logs can be added to an active span.") {
@@ -167,9 +201,182 @@ TEST_CASE("tracer") {
     CHECK(span);
     span->SetTag("abc", 123);
     span->Finish();
-    std::map<std::string, Value> expected_tags = {{"abc", 123}};
+    TagMap expected_tags = {{"abc", 123}};
     CHECK(recorder->top().tags == expected_tags);
   }
+
+  SECTION("Setting a tag that already exists overwrites its value.") {
+    auto span = tracer->StartSpan("a", {SetTag("xyz", 1), SetTag("abc", 2)});
+    CHECK(span);
+    span->SetTag("xyz", 3);
+    span->SetTag("def", 4);
+    span->Finish();
+    auto tags = recorder->top().tags;
+    std::vector<std::pair<std::string, Value>> expected_tags = {
+        {"abc", 2}, {"def", 4}, {"xyz", 3}};
+    CHECK(std::vector<std::pair<std::string, Value>>(
+              tags.begin(), tags.end()) == expected_tags);
+  }
+}
+
+TEST_CASE("tag_map") {
+  SECTION("Tags are found and iterated in key order however many there are.") {
+    for (size_t num_tags : {3, 40}) {
+      TagMap tags;
+      std::vector<std::string> keys;
+      for (size_t i = 0; i < num_tags; ++i) {
+        keys.push_back("key" + std::to_string((i * 7) % num_tags));
+        tags.insert_or_assign(keys.back(), Value{i});
+      }
+      tags.insert_or_assign(keys.front(), "overwritten");
+      tags["new"] = true;
+      REQUIRE(tags.size() == num_tags + 1);
+      CHECK(tags.at(keys.front()) == Value{"overwritten"});
+      for (size_t i = 1; i < num_tags; ++i) {
+        REQUIRE(tags.find(keys[i]) != tags.end());
+        CHECK(tags.find(keys[i])->second == Value{i});
+      }
+      CHECK(tags.find("key") == tags.end());
+      CHECK(tags.count("new") == 1);
+      CHECK(std::is_sorted(tags.begin(), tags.end(),
+                           [](const TagMap::value_type& lhs,
+                              const TagMap::value_type& rhs) {
+                             return lhs.first < rhs.first;
+                           }));
+      auto copy = tags;
+      CHECK(copy == tags);
+      copy["key0"] = 1;
+      CHECK(copy != tags);
+    }
+  }
+
+  SECTION("Every kind of value is kept when the tags grow.") {
+    TagMap tags;
+    Dictionary dictionary{{"a", Value{1}}};
+    Values values{Value{"b"}, Value{2.5}};
+    tags.insert_or_assign("dictionary", dictionary);
+    tags.insert_or_assign("values", values);
+    tags.insert_or_assign("string", "abc");
+    for (int i = 0; i < 20; ++i) {
+      tags.insert_or_assign("int" + std::to_string(i), i);
+    }
+    CHECK(tags.at("dictionary") == Value{dictionary});
+    CHECK(tags.at("values") == Value{values});
+    CHECK(tags.at("string") == Value{"abc"});
+    CHECK(tags.at("int19") == Value{19});
+  }
+}
+
+TEST_CASE("lazy_value") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  auto tracer = std::shared_ptr<opentracing::Tracer>{
+      new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Lazy tags and log fields are computed when resolved.") {
+    int num_calls = 0;
+    auto span = tracer->StartSpan("a");
+    SetLazyTag(*span, "lazy", LazyValue{[&num_calls] {
+                 ++num_calls;
+                 return Value{123};
+               }});
+    SetLazyTag(*span, "replaced", LazyValue{[] { return Value{1}; }});
+    span->SetTag("replaced", 2);
+    LogLazy(*span, {{"field", LazyValue{[] { return Value{"x"}; }}}});
+    span->Finish();
+    auto span_data = recorder->top();
+    CHECK(num_calls == 0);
+    ResolveLazyValues(span_data);
+    CHECK(num_calls == 1);
+    TagMap expected_tags = {{"lazy", 123}, {"replaced", 2}};
+    CHECK(span_data.tags == expected_tags);
+    REQUIRE(span_data.logs.size() == 1);
+    CHECK(span_data.logs[0].fields ==
+          std::vector<std::pair<std::string, Value>>{{"field", "x"}});
+    CHECK(!HasLazyValues(span_data));
+  }
+
+  SECTION("Lazy values compare by the values they compute.") {
+    CHECK(LazyValue{[] { return Value{1}; }} ==
+          LazyValue{[] { return Value{1}; }});
+    CHECK(LazyValue{[] { return Value{1}; }} != LazyValue{});
+  }
+
+  SECTION("Lazy values aren't computed for other tracers' unrecorded spans.") {
+    auto noop_tracer = MakeNoopTracer();
+    auto span = noop_tracer->StartSpan("a");
+    bool is_computed = false;
+    SetLazyTag(*span, "lazy", LazyValue{[&is_computed] {
+                 is_computed = true;
+                 return Value{};
+               }});
+    CHECK(!is_computed);
+  }
+}
+
+TEST_CASE("single_threaded_spans") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  tracer_options.thread_safe_spans = false;
+  auto tracer = std::shared_ptr<opentracing::Tracer>{
+      new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Spans record tags, logs, and baggage without locking.") {
+    auto span = tracer->StartSpan("a");
+    CHECK(span);
+    span->SetTag("abc", 123);
+    span->Log({{"xyz", 456}});
+    span->SetBaggageItem("b", "1");
+    CHECK(span->BaggageItem("b") == "1");
+    span->Finish();
+    auto span_data = recorder->top();
+    TagMap expected_tags = {{"abc", 123}};
+    CHECK(span_data.tags == expected_tags);
+    CHECK(span_data.logs.size() == 1);
+    CHECK(span_data.span_context.baggage.at("b") == "1");
+  }
+}
+
+TEST_CASE("non_owning_spans") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  tracer_options.spans_own_tracer = false;
+
+  SECTION("Spans don't share ownership of the tracer.") {
+    auto tracer = std::shared_ptr<opentracing::Tracer>{
+        new MockTracer{std::move(tracer_options)}};
+    auto span = tracer->StartSpan("a");
+    CHECK(span);
+    CHECK(tracer.use_count() == 1);
+    CHECK(&span->tracer() == tracer.get());
+    span->Finish();
+    CHECK(recorder->size() == 1);
+  }
+
+  SECTION("Close waits for spans finished on other threads.") {
+    auto tracer = std::shared_ptr<opentracing::Tracer>{
+        new MockTracer{std::move(tracer_options)}};
+    std::shared_ptr<Span> span{tracer->StartSpan("a")};
+    std::thread thread{[span] {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      span->Finish();
+    }};
+    span.reset();
+    tracer->Close();
+    CHECK(recorder->size() == 1);
+    thread.join();
+  }
+
+  SECTION("Spans can be started from a tracer that isn't in a shared_ptr.") {
+    MockTracer tracer{std::move(tracer_options)};
+    auto span = tracer.StartSpan("a");
+    CHECK(span);
+    span->Finish();
+    CHECK(recorder->size() == 1);
+  }
 }
 
 TEST_CASE("json_recorder") {
@@ -188,3 +395,912 @@ TEST_CASE("json_recorder") {
     CHECK(!oss->str().empty());
   }
 }
+
+// SynchronizedStringBuffer collects what's written to it from any thread and
+// lets a test wait for the output it expects.
+class SynchronizedStringBuffer : public std::streambuf {
+ public:
+  std::string str() const {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    return output_;
+  }
+
+  // Waits until the output contains s.
+  void WaitFor(const std::string& s) const {
+    std::unique_lock<std::mutex> lock{mutex_};
+    condition_.wait(lock,
+                    [&] { return output_.find(s) != std::string::npos; });
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (c != traits_type::eof()) {
+      auto ch = traits_type::to_char_type(c);
+      xsputn(&ch, 1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    {
+      std::lock_guard<std::mutex> lock_guard{mutex_};
+      output_.append(s, static_cast<size_t>(n));
+    }
+    condition_.notify_all();
+    return n;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  mutable std::condition_variable condition_;
+  std::string output_;
+};
+
+TEST_CASE("streaming_json_recorder") {
+  SynchronizedStringBuffer buffer;
+  JsonRecorderOptions recorder_options;
+  recorder_options.streaming = true;
+  recorder_options.max_buffered_spans = 2;
+  recorder_options.flush_interval = std::chrono::hours{1};
+
+  SECTION("Spans are written once max_buffered_spans are recorded.") {
+    auto recorder = new JsonRecorder{
+        std::unique_ptr<std::ostream>{new std::ostream{&buffer}},
+        recorder_options};
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(recorder);
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    tracer->StartSpan("a")->Finish();
+    CHECK(buffer.str().empty());
+    tracer->StartSpan("b")->Finish();
+    buffer.WaitFor("},{");
+    CHECK(buffer.str().front() == '[');
+    tracer->StartSpan("c")->Finish();
+    tracer->Close();
+    auto json = buffer.str();
+    CHECK(json.back() == ']');
+    CHECK(json.find(R"("operation_name":"c")") != std::string::npos);
+    CHECK(recorder->num_dropped_spans() == 0);
+  }
+
+  SECTION("Spans are dropped once max_buffered_bytes are waiting.") {
+    recorder_options.max_buffered_spans = 1000;
+    recorder_options.max_buffered_bytes = 4096;
+    auto recorder = new JsonRecorder{
+        std::unique_ptr<std::ostream>{new std::ostream{&buffer}},
+        recorder_options};
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(recorder);
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    const int num_spans = 100;
+    for (int i = 0; i < num_spans; ++i) {
+      tracer->StartSpan("a", {SetTag("payload", std::string(100, 'x'))})
+          ->Finish();
+    }
+    auto num_dropped_spans = recorder->num_dropped_spans();
+    CHECK(num_dropped_spans > 0);
+    CHECK(num_dropped_spans < num_spans);
+    tracer->Close();
+    auto json = buffer.str();
+    size_t num_written_spans = 0;
+    for (auto position = json.find("operation_name");
+         position != std::string::npos;
+         position = json.find("operation_name", position + 1)) {
+      ++num_written_spans;
+    }
+    CHECK(num_written_spans == num_spans - num_dropped_spans);
+  }
+
+  SECTION("Closing without spans writes an empty array.") {
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(new JsonRecorder{
+        std::unique_ptr<std::ostream>{new std::ostream{&buffer}},
+        recorder_options});
+    MockTracer{std::move(tracer_options)}.Close();
+    CHECK(buffer.str() == "[]");
+  }
+}
+
+TEST_CASE("json_recorder_flush") {
+  auto oss = new std::ostringstream{};
+  auto recorder = new JsonRecorder{std::unique_ptr<std::ostream>{oss}};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  auto tracer =
+      std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Flush writes the spans recorded so far.") {
+    tracer->StartSpan("a")->Finish();
+    tracer->StartSpan("b")->Finish();
+    CHECK(recorder->Flush());
+    auto flushed = oss->str();
+    CHECK(flushed.front() == '[');
+    CHECK(flushed.find("},{") != std::string::npos);
+    tracer->Close();
+    CHECK(oss->str() == flushed + "]");
+  }
+
+  SECTION("Spans not written before the deadline are kept.") {
+    tracer->StartSpan("a")->Finish();
+    CHECK(!recorder->Flush(SteadyTime{}));
+    CHECK(oss->str().empty());
+    CHECK(recorder->Flush());
+    CHECK(oss->str().find(R"("operation_name":"a")") != std::string::npos);
+  }
+
+  SECTION("Kept spans are written before spans recorded after them.") {
+    tracer->StartSpan("a")->Finish();
+    CHECK(!recorder->Flush(SteadyTime{}));
+    tracer->StartSpan("b")->Finish();
+    CHECK(recorder->Flush());
+    auto json = oss->str();
+    auto a_position = json.find(R"("operation_name":"a")");
+    auto b_position = json.find(R"("operation_name":"b")");
+    REQUIRE(a_position != std::string::npos);
+    REQUIRE(b_position != std::string::npos);
+    CHECK(a_position < b_position);
+  }
+}
+
+TEST_CASE("span_pool") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  tracer_options.span_pool_capacity = 1;
+  auto tracer = std::shared_ptr<opentracing::Tracer>{
+      new MockTracer{std::move(tracer_options)}};
+
+  SECTION("The memory of a destroyed span is reused for the next span.") {
+    auto span_a = tracer->StartSpan("a");
+    CHECK(span_a);
+    auto span_a_address = static_cast<void*>(span_a.get());
+    span_a.reset();
+    auto span_b = tracer->StartSpan("b");
+    CHECK(span_b);
+    CHECK(static_cast<void*>(span_b.get()) == span_a_address);
+    span_b->SetTag("abc", 123);
+    span_b->Finish();
+    auto spans = recorder->spans();
+    CHECK(spans.size() == 2);
+    CHECK(spans.at(1).operation_name == "b");
+    TagMap expected_tags = {{"abc", 123}};
+    CHECK(spans.at(1).tags == expected_tags);
+  }
+
+  SECTION("Spans destroyed after their thread's pool is released are freed.") {
+    std::thread{[&tracer] {
+      // Constructed before the pool's thread_local state, so it's destroyed
+      // after it.
+      static thread_local std::unique_ptr<opentracing::Span> span;
+      span = tracer->StartSpan("a");
+      span->Finish();
+    }}.join();
+    CHECK(recorder->size() == 1);
+  }
+}
+
+TEST_CASE("async_recorder") {
+  auto recorder = new InMemoryRecorder{};
+  AsyncRecorderOptions recorder_options;
+  recorder_options.max_batch_size = 4;
+  recorder_options.flush_interval = std::chrono::milliseconds{1};
+  auto async_recorder = new AsyncRecorder{
+      std::unique_ptr<Recorder>{recorder}, recorder_options};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(async_recorder);
+  auto tracer =
+      std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Spans are forwarded in the background.") {
+    tracer->StartSpan("a")->Finish();
+    for (int i = 0; i < 1000 && recorder->size() == 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    CHECK(recorder->size() == 1);
+  }
+
+  SECTION("Close forwards all queued spans.") {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&tracer] {
+        for (int j = 0; j < 100; ++j) {
+          tracer->StartSpan("a")->Finish();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    tracer->Close();
+    CHECK(recorder->size() == 400);
+    CHECK(async_recorder->num_dropped_spans() == 0);
+  }
+
+  SECTION("Spans recorded after Close are dropped and counted.") {
+    tracer->Close();
+    tracer->StartSpan("a")->Finish();
+    CHECK(recorder->size() == 0);
+    CHECK(async_recorder->num_dropped_spans() == 1);
+  }
+
+  SECTION("Every span is either forwarded or dropped when closing.") {
+    std::atomic<bool> is_done{false};
+    std::vector<std::thread> threads;
+    std::atomic<int> num_spans{0};
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] {
+        while (!is_done) {
+          tracer->StartSpan("a")->Finish();
+          ++num_spans;
+        }
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    std::thread close_thread{[&tracer] { tracer->Close(); }};
+    tracer->Close();
+    // Both calls to Close have finished forwarding.
+    auto num_forwarded_spans = recorder->size();
+    close_thread.join();
+    is_done = true;
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    CHECK(recorder->size() == num_forwarded_spans);
+    CHECK(num_forwarded_spans + async_recorder->num_dropped_spans() ==
+          static_cast<size_t>(num_spans));
+  }
+}
+
+// BlockedRecorder holds up the first span it records until it's released, so
+// that spans recorded in the meantime back up.
+class BlockedRecorder : public InMemoryRecorder {
+ public:
+  BlockedRecorder() : released_{release_.get_future().share()} {}
+
+  void Release() { release_.set_value(); }
+
+  void RecordSpan(SpanData&& span_data) noexcept override {
+    released_.wait();
+    InMemoryRecorder::RecordSpan(std::move(span_data));
+  }
+
+ private:
+  std::promise<void> release_;
+  std::shared_future<void> released_;
+};
+
+// TemporaryDirectory creates a new directory and removes it, along with the
+// files in it, when destroyed.
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory() {
+#ifdef _WIN32
+    char temp_path[MAX_PATH];
+    char path[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_path);
+    GetTempFileNameA(temp_path, "ot", 0, path);
+    DeleteFileA(path);
+    _mkdir(path);
+    path_ = path;
+#else
+    auto temp_path = std::getenv("TMPDIR");
+    path_ = std::string{temp_path != nullptr ? temp_path : "/tmp"} +
+            "/mocktracer_test_XXXXXX";
+    if (mkdtemp(&path_[0]) == nullptr) {
+      throw std::runtime_error{"failed to create " + path_};
+    }
+#endif
+  }
+
+  TemporaryDirectory(const TemporaryDirectory&) = delete;
+  TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+  ~TemporaryDirectory() {
+#ifdef _WIN32
+    WIN32_FIND_DATAA find_data;
+    auto find_handle = FindFirstFileA((path_ + "\\*").c_str(), &find_data);
+    if (find_handle != INVALID_HANDLE_VALUE) {
+      do {
+        DeleteFileA((path_ + "\\" + find_data.cFileName).c_str());
+      } while (FindNextFileA(find_handle, &find_data));
+      FindClose(find_handle);
+    }
+    _rmdir(path_.c_str());
+#else
+    auto directory = opendir(path_.c_str());
+    if (directory != nullptr) {
+      while (auto entry = readdir(directory)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+          unlink((path_ + "/" + name).c_str());
+        }
+      }
+      closedir(directory);
+    }
+    rmdir(path_.c_str());
+#endif
+  }
+
+  const std::string& path() const noexcept { return path_; }
+
+ private:
+  std::string path_;
+};
+
+TEST_CASE("async_recorder spool") {
+  TemporaryDirectory spool_directory;
+  AsyncRecorderOptions recorder_options;
+  recorder_options.max_queue_size = 1024;
+  recorder_options.max_batch_size = 4;
+  recorder_options.flush_interval = std::chrono::milliseconds{1};
+  recorder_options.spool_directory = spool_directory.path();
+  recorder_options.spool_high_water_mark = 8;
+  recorder_options.max_spool_segment_size = 1024;
+
+  SECTION("Spans overflow to the spool and are forwarded in order.") {
+    // Every span is recorded while the recorder is blocked, so the queue
+    // passes the high-water mark and the spans go through the spool.
+    auto recorder = new BlockedRecorder{};
+    auto async_recorder = new AsyncRecorder{
+        std::unique_ptr<Recorder>{recorder}, recorder_options};
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(async_recorder);
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    for (int i = 0; i < 500; ++i) {
+      tracer->StartSpan(std::to_string(i))->Finish();
+    }
+    recorder->Release();
+    tracer->Close();
+    CHECK(async_recorder->num_dropped_spans() == 0);
+    auto spans = recorder->spans();
+    REQUIRE(spans.size() == 500);
+    for (int i = 0; i < 500; ++i) {
+      CHECK(spans[i].operation_name == std::to_string(i));
+    }
+  }
+
+  SECTION("Spooled spans left by an earlier process are forwarded first.") {
+    SpanData span_data;
+    span_data.operation_name = "earlier";
+    span_data.duration = std::chrono::nanoseconds{0};
+    auto segment_path = recorder_options.spool_directory +
+                        "/spool-00000000000000000007.bin";
+    {
+      std::ofstream out{segment_path, std::ios::binary};
+      ToBinary(out, {span_data});
+    }
+
+    auto recorder = new InMemoryRecorder{};
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(new AsyncRecorder{
+        std::unique_ptr<Recorder>{recorder}, recorder_options});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    tracer->StartSpan("later")->Finish();
+    tracer->Close();
+    auto spans = recorder->spans();
+    REQUIRE(spans.size() == 2);
+    CHECK(spans[0].operation_name == "earlier");
+    CHECK(spans[1].operation_name == "later");
+    CHECK(!std::ifstream{segment_path});
+  }
+}
+
+TEST_CASE("sampler") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+
+  SECTION("Spans of unsampled traces aren't recorded.") {
+    tracer_options.sampler.reset(new ConstSampler{false});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    auto span_a = tracer->StartSpan("a");
+    CHECK(!span_a->IsRecording());
+    CHECK(!span_a->context().IsSampled());
+    bool is_computed = false;
+    SetLazyTag(*span_a, "lazy", LazyValue{[&is_computed] {
+                 is_computed = true;
+                 return Value{};
+               }});
+    span_a->SetTag("abc", 123);
+    auto span_b = tracer->StartSpan("b", {ChildOf(&span_a->context())});
+    CHECK(span_b->context().ToTraceID() == span_a->context().ToTraceID());
+    span_b->Finish();
+    span_a->Finish();
+    CHECK(recorder->size() == 0);
+    CHECK(!is_computed);
+  }
+
+  SECTION("Baggage propagates through unsampled spans.") {
+    tracer_options.sampler.reset(new ConstSampler{false});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    auto span_a = tracer->StartSpan("a");
+    span_a->SetBaggageItem("b", "1");
+    CHECK(span_a->BaggageItem("b") == "1");
+
+    auto span_b = tracer->StartSpan("b", {ChildOf(&span_a->context())});
+    CHECK(span_b->BaggageItem("b") == "1");
+    span_b->SetBaggageItem("c", "2");
+    CHECK(span_a->BaggageItem("c").empty());
+
+    std::stringstream carrier;
+    REQUIRE(tracer->Inject(span_b->context(), carrier));
+    auto span_context_maybe = tracer->Extract(carrier);
+    REQUIRE(span_context_maybe);
+    auto span_c =
+        tracer->StartSpan("c", {ChildOf(span_context_maybe->get())});
+    CHECK(!span_c->IsRecording());
+    CHECK(span_c->BaggageItem("b") == "1");
+    CHECK(span_c->BaggageItem("c") == "2");
+  }
+
+  SECTION("Children inherit the decision for their trace.") {
+    tracer_options.sampler.reset(new ProbabilisticSampler{0.5});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    for (int i = 0; i < 1000; ++i) {
+      auto span_a = tracer->StartSpan("a");
+      auto span_b = tracer->StartSpan("b", {ChildOf(&span_a->context())});
+      CHECK(span_b->IsRecording() == span_a->IsRecording());
+    }
+    auto spans = recorder->spans();
+    CHECK(spans.size() > 600);
+    CHECK(spans.size() < 1400);
+    std::map<uint64_t, int> trace_sizes;
+    for (auto& span : spans) {
+      ++trace_sizes[span.span_context.trace_id];
+    }
+    for (auto& trace_size : trace_sizes) {
+      CHECK(trace_size.second == 2);
+    }
+  }
+
+  SECTION("Extracted contexts are sampled by trace id.") {
+    tracer_options.sampler.reset(new ProbabilisticSampler{0.5});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    ProbabilisticSampler sampler{0.5};
+    for (int i = 0; i < 100; ++i) {
+      auto span_a = tracer->StartSpan("a");
+      std::stringstream carrier;
+      REQUIRE(tracer->Inject(span_a->context(), carrier));
+      auto span_context_maybe = tracer->Extract(carrier);
+      REQUIRE(span_context_maybe);
+      auto num_spans = recorder->size();
+      tracer->StartSpan("b", {ChildOf(span_context_maybe->get())})->Finish();
+      auto trace_id = std::stoull(span_a->context().ToTraceID());
+      CHECK((recorder->size() > num_spans) ==
+            sampler.ShouldSample(trace_id, ""));
+    }
+  }
+
+  SECTION("ProbabilisticSampler samples every trace or none at the extremes.") {
+    ProbabilisticSampler always{1.0};
+    ProbabilisticSampler never{0.0};
+    CHECK(always.ShouldSample(std::numeric_limits<uint64_t>::max(), ""));
+    CHECK(!never.ShouldSample(0, ""));
+  }
+
+  SECTION("RateLimitingSampler limits the number of sampled traces.") {
+    RateLimitingSampler sampler{10};
+    int num_sampled = 0;
+    for (int i = 0; i < 100; ++i) {
+      num_sampled += sampler.ShouldSample(0, "") ? 1 : 0;
+    }
+    CHECK(num_sampled >= 10);
+    CHECK(num_sampled <= 11);
+  }
+
+  SECTION("A sampling.priority tag overrides the sampler.") {
+    tracer_options.sampler.reset(new ConstSampler{false});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    auto span_a = tracer->StartSpan("a", {SetTag{ext::sampling_priority, 1}});
+    CHECK(span_a->IsRecording());
+    auto span_b = tracer->StartSpan("b", {ChildOf(&span_a->context())});
+    CHECK(span_b->IsRecording());
+    auto span_c = tracer->StartSpan(
+        "c", {ChildOf(&span_a->context()), SetTag{ext::sampling_priority, 0}});
+    CHECK(!span_c->IsRecording());
+  }
+
+  SECTION("AdaptiveSampler divides the target rate between operations.") {
+    AdaptiveSamplerOptions sampler_options;
+    sampler_options.target_traces_per_second = 100;
+    sampler_options.retune_period = SteadyClock::duration::zero();
+    AdaptiveSampler sampler{sampler_options};
+    for (int i = 0; i < 10000; ++i) {
+      CHECK(sampler.ShouldSample(i, "hot"));
+    }
+    for (int i = 0; i < 10; ++i) {
+      sampler.ShouldSample(i, "rare");
+    }
+    sampler.Retune(std::chrono::seconds{1});
+    CHECK(sampler.sampling_probability("rare") == 1.0);
+    CHECK(sampler.sampling_probability("hot") == Approx(0.009));
+    CHECK(sampler.sampling_probability("new") == 1.0);
+
+    int num_sampled = 0;
+    for (uint64_t i = 0; i < 10000; ++i) {
+      num_sampled += sampler.ShouldSample(i * 0x9e3779b97f4a7c15ull, "hot");
+    }
+    CHECK(num_sampled > 50);
+    CHECK(num_sampled < 130);
+  }
+
+  SECTION("AdaptiveSampler shares a slot between operations past its limit.") {
+    AdaptiveSamplerOptions sampler_options;
+    sampler_options.target_traces_per_second = 10;
+    sampler_options.max_operations = 1;
+    sampler_options.retune_period = SteadyClock::duration::zero();
+    AdaptiveSampler sampler{sampler_options};
+    for (int i = 0; i < 100; ++i) {
+      sampler.ShouldSample(i, "a");
+      sampler.ShouldSample(i, "b");
+      sampler.ShouldSample(i, "c");
+    }
+    sampler.Retune(std::chrono::seconds{1});
+    CHECK(sampler.sampling_probability("a") == Approx(0.05));
+    CHECK(sampler.sampling_probability("b") == Approx(0.025));
+    CHECK(sampler.sampling_probability("c") == Approx(0.025));
+  }
+}
+
+TEST_CASE("tail_sampling_recorder") {
+  auto recorder = new InMemoryRecorder{};
+  TailSamplingOptions recorder_options;
+  recorder_options.latency_threshold = std::chrono::seconds{1};
+  recorder_options.operation_names = {"keep"};
+  recorder_options.num_shards = 2;
+
+  auto make_span = [](uint64_t trace_id, uint64_t span_id,
+                      uint64_t parent_span_id, const char* operation_name) {
+    SpanData span_data;
+    span_data.span_context.trace_id = trace_id;
+    span_data.span_context.span_id = span_id;
+    if (parent_span_id != 0) {
+      span_data.references = {
+          {SpanReferenceType::ChildOfRef, trace_id, parent_span_id}};
+    }
+    span_data.operation_name = operation_name;
+    span_data.duration = std::chrono::milliseconds{1};
+    return span_data;
+  };
+
+  SECTION("Traces are kept or dropped whole when their root finishes.") {
+    TailSamplingRecorder tail_recorder{std::unique_ptr<Recorder>{recorder},
+                                       recorder_options};
+    auto error_span = make_span(1, 2, 1, "a");
+    error_span.tags = {{"error", true}};
+    tail_recorder.RecordSpan(std::move(error_span));
+    tail_recorder.RecordSpan(make_span(2, 2, 1, "a"));
+    auto slow_span = make_span(3, 2, 1, "a");
+    slow_span.duration = std::chrono::seconds{2};
+    tail_recorder.RecordSpan(std::move(slow_span));
+    tail_recorder.RecordSpan(make_span(4, 2, 1, "keep"));
+    CHECK(recorder->size() == 0);
+    for (uint64_t trace_id = 1; trace_id <= 4; ++trace_id) {
+      tail_recorder.RecordSpan(make_span(trace_id, 1, 0, "root"));
+    }
+    CHECK(tail_recorder.num_kept_traces() == 3);
+    CHECK(tail_recorder.num_dropped_traces() == 1);
+    auto spans = recorder->spans();
+    CHECK(spans.size() == 6);
+    for (auto& span_data : spans) {
+      CHECK(span_data.span_context.trace_id != 2);
+    }
+  }
+
+  SECTION("Spans continuing a trace from another process are local roots.") {
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(new TailSamplingRecorder{
+        std::unique_ptr<Recorder>{recorder}, recorder_options});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    auto client_span = tracer->StartSpan("client");
+    std::stringstream carrier;
+    REQUIRE(tracer->Inject(client_span->context(), carrier));
+    auto span_context_maybe = tracer->Extract(carrier);
+    REQUIRE(span_context_maybe);
+    auto server_span =
+        tracer->StartSpan("keep", {ChildOf(span_context_maybe->get())});
+    auto child_span =
+        tracer->StartSpan("a", {ChildOf(&server_span->context())});
+    child_span->Finish();
+    CHECK(recorder->size() == 0);
+    server_span->Finish();
+    REQUIRE(recorder->size() == 2);
+    CHECK(recorder->top().has_remote_parent);
+    CHECK(!recorder->spans()[0].has_remote_parent);
+  }
+
+  SECTION("Spans recorded after their trace was decided follow it.") {
+    TailSamplingRecorder tail_recorder{std::unique_ptr<Recorder>{recorder},
+                                       recorder_options};
+    tail_recorder.RecordSpan(make_span(2, 1, 0, "root"));
+    tail_recorder.RecordSpan(make_span(4, 1, 0, "keep"));
+    CHECK(recorder->size() == 1);
+    tail_recorder.RecordSpan(make_span(2, 2, 1, "a"));
+    tail_recorder.RecordSpan(make_span(4, 2, 1, "a"));
+    CHECK(recorder->size() == 2);
+    tail_recorder.Close();
+    CHECK(recorder->size() == 2);
+    CHECK(tail_recorder.num_kept_traces() == 1);
+    CHECK(tail_recorder.num_dropped_traces() == 1);
+  }
+
+  SECTION("Traces without a local root are decided after the timeout.") {
+    recorder_options.decision_timeout = std::chrono::milliseconds{1};
+    TailSamplingRecorder tail_recorder{std::unique_ptr<Recorder>{recorder},
+                                       recorder_options};
+    tail_recorder.RecordSpan(make_span(2, 2, 1, "keep"));
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    tail_recorder.RecordSpan(make_span(4, 2, 1, "a"));
+    CHECK(recorder->size() == 1);
+    tail_recorder.Close();
+    CHECK(tail_recorder.num_kept_traces() == 1);
+    CHECK(tail_recorder.num_dropped_traces() == 1);
+  }
+
+  SECTION("Timed out traces are decided without more spans recorded.") {
+    recorder_options.decision_timeout = std::chrono::milliseconds{1};
+    recorder_options.timeout_check_interval = std::chrono::milliseconds{1};
+    TailSamplingRecorder tail_recorder{std::unique_ptr<Recorder>{recorder},
+                                       recorder_options};
+    tail_recorder.RecordSpan(make_span(2, 2, 1, "keep"));
+    for (uint64_t trace_id = 3; trace_id < 100; ++trace_id) {
+      tail_recorder.RecordSpan(make_span(trace_id, 1, 0, "root"));
+    }
+    for (int i = 0; i < 1000 && recorder->size() == 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    CHECK(recorder->size() == 1);
+    CHECK(tail_recorder.num_kept_traces() == 1);
+    CHECK(tail_recorder.num_dropped_traces() == 97);
+  }
+
+  SECTION("The oldest traces are decided early when the buffer is full.") {
+    recorder_options.max_buffered_spans = 8;
+    TailSamplingRecorder tail_recorder{std::unique_ptr<Recorder>{recorder},
+                                       recorder_options};
+    tail_recorder.RecordSpan(make_span(2, 2, 1, "keep"));
+    for (uint64_t span_id = 3; span_id < 10; ++span_id) {
+      tail_recorder.RecordSpan(make_span(4, span_id, 1, "a"));
+    }
+    CHECK(recorder->size() == 1);
+    CHECK(tail_recorder.num_kept_traces() == 1);
+  }
+}
+
+TEST_CASE("task_context") {
+  auto recorder = new InMemoryRecorder{};
+  MockTracerOptions tracer_options;
+  tracer_options.recorder.reset(recorder);
+  auto tracer =
+      std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+
+  SECTION("Tasks record spans as children of the submitting span.") {
+    auto span_a = tracer->StartSpan("a");
+    span_a->SetBaggageItem("b", "1");
+    TaskContextOptions options;
+    options.tracer = tracer;
+    options.queue_wait_operation_name = "queue_wait";
+    options.run_operation_name = "run";
+    std::function<void()> task;
+    {
+      auto scope = ScopeManager::Activate(*span_a);
+      task = MakeContextTask(
+          [&tracer] {
+            auto span = tracer->StartSpan("work", {ChildOfActiveSpan{}});
+            CHECK(span->BaggageItem("b") == "1");
+            CHECK(span->BaggageItem("c").empty());
+          },
+          options);
+    }
+    span_a->SetBaggageItem("c", "2");
+    span_a->Finish();
+    std::thread{task}.join();
+
+    auto spans = recorder->spans();
+    REQUIRE(spans.size() == 4);
+    auto& span_data_a = spans[0];
+    auto& queue_wait_span = spans[1];
+    auto& work_span = spans[2];
+    auto& run_span = spans[3];
+    CHECK(queue_wait_span.operation_name == "queue_wait");
+    CHECK(work_span.operation_name == "work");
+    CHECK(run_span.operation_name == "run");
+    CHECK(queue_wait_span.start_timestamp <= run_span.start_timestamp);
+    REQUIRE(queue_wait_span.references.size() == 1);
+    CHECK(queue_wait_span.references[0].span_id ==
+          span_data_a.span_context.span_id);
+    REQUIRE(run_span.references.size() == 1);
+    CHECK(run_span.references[0].span_id == span_data_a.span_context.span_id);
+    REQUIRE(work_span.references.size() == 1);
+    CHECK(work_span.references[0].span_id == run_span.span_context.span_id);
+    CHECK(work_span.span_context.baggage ==
+          (std::map<std::string, std::string>{{"b", "1"}}));
+  }
+
+  SECTION("Queue wait and run spans cover the wait and each run.") {
+    auto span_a = tracer->StartSpan("a");
+    TaskContextOptions options;
+    options.tracer = tracer;
+    options.queue_wait_operation_name = "queue_wait";
+    options.run_operation_name = "run";
+    std::function<void()> task;
+    SystemTime submit_timestamp;
+    {
+      auto scope = ScopeManager::Activate(*span_a);
+      submit_timestamp = SystemClock::now();
+      task = MakeContextTask(
+          [] { std::this_thread::sleep_for(std::chrono::milliseconds{2}); },
+          options);
+    }
+    span_a->Finish();
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    auto run_timestamp = SystemClock::now();
+    auto task_copy = task;
+    task();
+    task_copy();
+
+    auto spans = recorder->spans();
+    REQUIRE(spans.size() == 4);
+    auto& span_data_a = spans[0];
+    auto& queue_wait_span = spans[1];
+    CHECK(queue_wait_span.operation_name == "queue_wait");
+    CHECK(queue_wait_span.start_timestamp >= submit_timestamp);
+    CHECK(queue_wait_span.start_timestamp <= run_timestamp);
+    CHECK(queue_wait_span.duration >= std::chrono::milliseconds{5});
+    for (auto& span_data : {queue_wait_span, spans[2], spans[3]}) {
+      CHECK(span_data.span_context.trace_id ==
+            span_data_a.span_context.trace_id);
+      REQUIRE(span_data.references.size() == 1);
+      CHECK(span_data.references[0].reference_type ==
+            SpanReferenceType::ChildOfRef);
+      CHECK(span_data.references[0].span_id ==
+            span_data_a.span_context.span_id);
+    }
+    for (auto& run_span : {spans[2], spans[3]}) {
+      CHECK(run_span.operation_name == "run");
+      CHECK(run_span.start_timestamp >= run_timestamp);
+      CHECK(run_span.duration >= std::chrono::milliseconds{2});
+    }
+    CHECK(spans[3].start_timestamp >= spans[2].start_timestamp);
+  }
+
+  SECTION("Tasks run with a span activated through a shared_ptr itself.") {
+    std::shared_ptr<Span> span_a{tracer->StartSpan("a")};
+    TaskContextOptions options;
+    options.tracer = tracer;
+    options.run_operation_name = "run";
+    std::function<void()> task;
+    std::function<void()> task_without_spans;
+    {
+      auto scope = ScopeManager::Activate(span_a);
+      task = MakeContextTask([] {}, options);
+      task_without_spans = MakeContextTask(
+          [] { ScopeManager::ActiveSpan()->SetTag("in_task", true); });
+    }
+    std::thread{task}.join();
+    std::thread{task_without_spans}.join();
+    span_a->Finish();
+
+    auto spans = recorder->spans();
+    REQUIRE(spans.size() == 2);
+    auto& run_span = spans[0];
+    auto& span_data_a = spans[1];
+    CHECK(run_span.operation_name == "run");
+    REQUIRE(run_span.references.size() == 1);
+    CHECK(run_span.references[0].span_id == span_data_a.span_context.span_id);
+    CHECK(span_data_a.tags == TagMap{{"in_task", true}});
+  }
+
+  SECTION("Clones share baggage until it's modified.") {
+    auto span_a = tracer->StartSpan("a");
+    span_a->SetBaggageItem("b", "1");
+    auto span_context = span_a->context().Clone();
+    auto span_b = tracer->StartSpan("b", {ChildOf(span_context.get())});
+    span_b->SetBaggageItem("c", "2");
+    span_a->SetBaggageItem("d", "3");
+    CHECK(span_a->BaggageItem("c").empty());
+    CHECK(span_b->BaggageItem("b") == "1");
+    CHECK(span_b->BaggageItem("d").empty());
+    std::map<std::string, std::string> cloned_baggage;
+    span_context->ForeachBaggageItem(
+        [&](const std::string& key, const std::string& value) {
+          cloned_baggage[key] = value;
+          return true;
+        });
+    CHECK(cloned_baggage == (std::map<std::string, std::string>{{"b", "1"}}));
+  }
+}
+
+TEST_CASE("clock") {
+  SECTION("Spans and logs take their timestamps from the tracer's clock.") {
+    // Ticks are milliseconds since a fixed time, and advance on every read.
+    struct FakeClock : Clock {
+      mutable uint64_t ticks = 0;
+
+      uint64_t Now() const noexcept override { return ticks++; }
+
+      SystemTime ToSystemTime(uint64_t ticks) const noexcept override {
+        return SystemTime{std::chrono::milliseconds{ticks + 2000}};
+      }
+    };
+    auto recorder = new InMemoryRecorder{};
+    MockTracerOptions tracer_options;
+    tracer_options.recorder.reset(recorder);
+    tracer_options.clock.reset(new FakeClock{});
+    auto tracer =
+        std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+    auto span = tracer->StartSpan("a");
+    span->Log({{"abc", 123}});
+    span->Finish();
+    auto span_data = recorder->top();
+    CHECK(span_data.start_timestamp ==
+          SystemTime{std::chrono::milliseconds{2000}});
+    REQUIRE(span_data.logs.size() == 1);
+    CHECK(span_data.logs[0].timestamp ==
+          SystemTime{std::chrono::milliseconds{2001}});
+    // The duration is measured on the steady clock.
+    CHECK(span_data.duration >= SteadyClock::duration::zero());
+    CHECK(span_data.duration < std::chrono::milliseconds{100});
+  }
+
+  SECTION("Durations of spans traced with a clock are never negative.") {
+    std::string error_message;
+    std::vector<std::unique_ptr<Clock>> clocks;
+    auto tsc_clock_maybe =
+        MakeTscClock(std::chrono::milliseconds{10}, error_message);
+    if (tsc_clock_maybe) {
+      clocks.emplace_back(std::move(*tsc_clock_maybe));
+    }
+    auto coarse_clock_maybe = MakeCoarseClock(error_message);
+    if (coarse_clock_maybe) {
+      clocks.emplace_back(std::move(*coarse_clock_maybe));
+    }
+    for (auto& clock : clocks) {
+      auto recorder = new InMemoryRecorder{};
+      MockTracerOptions tracer_options;
+      tracer_options.recorder.reset(recorder);
+      tracer_options.clock = std::move(clock);
+      auto tracer =
+          std::shared_ptr<Tracer>{new MockTracer{std::move(tracer_options)}};
+      for (int i = 0; i < 1000; ++i) {
+        tracer->StartSpan("a")->Finish();
+      }
+      for (auto& span_data : recorder->spans()) {
+        CHECK(span_data.duration >= SteadyClock::duration::zero());
+      }
+    }
+  }
+
+  SECTION("Supported clocks track the system clock.") {
+    std::string error_message;
+    std::vector<std::unique_ptr<Clock>> clocks;
+    auto tsc_clock_maybe =
+        MakeTscClock(std::chrono::milliseconds{10}, error_message);
+    if (tsc_clock_maybe) {
+      clocks.emplace_back(std::move(*tsc_clock_maybe));
+    } else {
+      CHECK(!error_message.empty());
+    }
+    auto coarse_clock_maybe = MakeCoarseClock(error_message);
+    if (coarse_clock_maybe) {
+      clocks.emplace_back(std::move(*coarse_clock_maybe));
+    }
+    for (auto& clock : clocks) {
+      auto ticks = clock->Now();
+      CHECK(clock->Now() >= ticks);
+      auto system_error = clock->ToSystemTime(ticks) - SystemClock::now();
+      CHECK(std::abs(std::chrono::duration<double>(system_error).count()) <
+            0.1);
+    }
+  }
+}
@@ -0,0 +1,24 @@
+// Prints the spans kept in a flight recording as JSON.
+//
+// Usage: extract_flight_recording <file>
+
+#include <opentracing/mocktracer/flight_recorder.h>
+#include <opentracing/mocktracer/json.h>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: extract_flight_recording <file>\n";
+    return 1;
+  }
+  std::string error_message;
+  auto spans =
+      opentracing::mocktracer::ReadFlightRecording(argv[1], error_message);
+  if (!spans) {
+    std::cerr << "Error: " << error_message << "\n";
+    return 1;
+  }
+  opentracing::mocktracer::ToJson(std::cout, *spans);
+  std::cout << "\n";
+  return std::cout.good() ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Times starting and finishing spans with and without a span pool, and counts
+// the heap allocations made per span. Finished spans go to a recorder that
+// drops them, so the numbers don't include a recorder's own work.
+//
+// Build with optimizations, e.g. CMAKE_BUILD_TYPE=Release.
+//
+// Usage: span_pool_benchmark [iterations]
+
+#include <opentracing/mocktracer/tracer.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+using opentracing::SteadyClock;
+using opentracing::mocktracer::MockTracer;
+using opentracing::mocktracer::MockTracerOptions;
+using opentracing::mocktracer::Recorder;
+using opentracing::mocktracer::SpanData;
+
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+namespace {
+class DroppingRecorder : public Recorder {
+ public:
+  void RecordSpan(SpanData&& span_data) noexcept override {
+    SpanData dropped_span_data{std::move(span_data)};
+  }
+};
+
+std::shared_ptr<opentracing::Tracer> MakeTracer(size_t span_pool_capacity) {
+  MockTracerOptions options;
+  options.recorder.reset(new DroppingRecorder{});
+  options.span_pool_capacity = span_pool_capacity;
+  return std::shared_ptr<opentracing::Tracer>{
+      new MockTracer{std::move(options)}};
+}
+
+// Starts and finishes a span, optionally with a few tags and a log record.
+void RecordSpan(const opentracing::Tracer& tracer, bool is_annotated) {
+  auto span = tracer.StartSpan("GET /api/v1/users");
+  if (is_annotated) {
+    span->SetTag("http.method", "GET");
+    span->SetTag("http.status_code", 200);
+    span->SetTag("component", "benchmark");
+    span->Log({{"event", "response"}, {"size", 1234}});
+  }
+  span->Finish();
+}
+
+struct Result {
+  double nanoseconds;
+  double allocations;
+};
+
+Result Measure(const opentracing::Tracer& tracer, bool is_annotated,
+               size_t iterations) {
+  // Warm up the pool.
+  for (size_t i = 0; i < 100; ++i) {
+    RecordSpan(tracer, is_annotated);
+  }
+  auto start_allocations = num_allocations.load(std::memory_order_relaxed);
+  auto start = SteadyClock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    RecordSpan(tracer, is_annotated);
+  }
+  auto elapsed = SteadyClock::now() - start;
+  auto allocations =
+      num_allocations.load(std::memory_order_relaxed) - start_allocations;
+  return {std::chrono::duration<double, std::nano>(elapsed).count() /
+              static_cast<double>(iterations),
+          static_cast<double>(allocations) / static_cast<double>(iterations)};
+}
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t iterations = 1000000;
+  if (argc > 1) {
+    iterations = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (iterations == 0) {
+    return 1;
+  }
+  auto unpooled_tracer = MakeTracer(0);
+  auto pooled_tracer = MakeTracer(1024);
+  std::printf("%-10s %13s %13s %15s %15s\n", "span", "unpooled", "pooled",
+              "allocs unpooled", "allocs pooled");
+  for (bool is_annotated : {false, true}) {
+    auto unpooled = Measure(*unpooled_tracer, is_annotated, iterations);
+    auto pooled = Measure(*pooled_tracer, is_annotated, iterations);
+    std::printf("%-10s %10.1f ns %10.1f ns %15.2f %15.2f\n",
+                is_annotated ? "annotated" : "bare", unpooled.nanoseconds,
+                pooled.nanoseconds, unpooled.allocations, pooled.allocations);
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Compares TagMap, which SpanData uses for its tags, with the
+// std::map<std::string, Value> it replaced, and times the JSON encoding of a
+// span's tags. Tags are inserted the way MockSpan::SetTag sets them with each
+// container, and the heap allocations made per span's worth of inserts are
+// counted.
+//
+// ToJson only accepts a TagMap, so the "json" columns encode the tags of each
+// container with the same minimal writer, which iterates them in key order
+// the way ToJson does; "ToJson flat" times ToJson on a span with the tags.
+//
+// Usage: tag_map_benchmark [iterations]
+
+#include <opentracing/mocktracer/json.h>
+#include <opentracing/mocktracer/tag_map.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using opentracing::SteadyClock;
+using opentracing::Value;
+using opentracing::mocktracer::SpanData;
+using opentracing::mocktracer::TagMap;
+
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+namespace {
+using StdTagMap = std::map<std::string, Value>;
+
+// The keys are set in a fixed, shuffled order so that neither container is
+// always appended to at its end.
+std::vector<std::string> MakeKeys(size_t num_tags) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_tags; ++i) {
+    keys.push_back("tag." + std::to_string((i * 7919) % num_tags));
+  }
+  return keys;
+}
+
+template <class F>
+double TimeNanoseconds(size_t iterations, F f) {
+  auto start = SteadyClock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    f();
+  }
+  auto elapsed = SteadyClock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(iterations);
+}
+
+void Insert(StdTagMap& tags, const std::vector<std::string>& keys) {
+  for (auto& key : keys) {
+    tags[key] = Value{123};
+  }
+}
+
+void Insert(TagMap& tags, const std::vector<std::string>& keys) {
+  for (auto& key : keys) {
+    tags.insert_or_assign(key, Value{123});
+  }
+}
+
+template <class Map>
+size_t CountInsertAllocations(const std::vector<std::string>& keys) {
+  auto start = num_allocations.load(std::memory_order_relaxed);
+  {
+    Map tags;
+    Insert(tags, keys);
+  }
+  return num_allocations.load(std::memory_order_relaxed) - start;
+}
+
+// Writes the tags as a JSON object. Every tag the benchmark sets has an
+// integer value.
+template <class Map>
+size_t WriteTagsJson(const Map& tags, std::string& out) {
+  out.clear();
+  out.push_back('{');
+  for (auto& tag : tags) {
+    if (out.size() > 1) {
+      out.push_back(',');
+    }
+    out.push_back('"');
+    out.append(tag.first);
+    out.append("\":");
+    out.append(std::to_string(tag.second.template get<int64_t>()));
+  }
+  out.push_back('}');
+  return out.size();
+}
+
+template <class Map>
+size_t Lookup(const Map& tags, const std::vector<std::string>& keys) {
+  size_t num_found = 0;
+  for (auto& key : keys) {
+    num_found += tags.count(key);
+  }
+  return num_found;
+}
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t iterations = 100000;
+  if (argc > 1) {
+    iterations = std::strtoul(argv[1], nullptr, 10);
+  }
+  size_t sink = 0;
+  std::printf("%4s %13s %13s %12s %12s %13s %13s %13s %13s %13s\n", "tags",
+              "insert map", "insert flat", "allocs map", "allocs flat",
+              "lookup map", "lookup flat", "json map", "json flat",
+              "ToJson flat");
+  for (size_t num_tags : {2, 4, 8, 16, 32, 64}) {
+    auto keys = MakeKeys(num_tags);
+
+    auto insert_map = TimeNanoseconds(iterations, [&] {
+      StdTagMap tags;
+      Insert(tags, keys);
+      sink += tags.size();
+    });
+    auto insert_flat = TimeNanoseconds(iterations, [&] {
+      TagMap tags;
+      Insert(tags, keys);
+      sink += tags.size();
+    });
+
+    StdTagMap std_tags;
+    Insert(std_tags, keys);
+    TagMap tags;
+    Insert(tags, keys);
+    auto lookup_map = TimeNanoseconds(
+        iterations, [&] { sink += Lookup(std_tags, keys); });
+    auto lookup_flat =
+        TimeNanoseconds(iterations, [&] { sink += Lookup(tags, keys); });
+
+    std::string json;
+    json.reserve(4096);
+    auto json_map = TimeNanoseconds(
+        iterations, [&] { sink += WriteTagsJson(std_tags, json); });
+    auto json_flat =
+        TimeNanoseconds(iterations, [&] { sink += WriteTagsJson(tags, json); });
+
+    std::vector<SpanData> spans(1);
+    spans[0].tags = tags;
+    std::ostringstream out;
+    auto to_json = TimeNanoseconds(iterations / 10 + 1, [&] {
+      out.str({});
+      opentracing::mocktracer::ToJson(out, spans);
+      sink += static_cast<size_t>(out.tellp());
+    });
+
+    auto allocations_map = CountInsertAllocations<StdTagMap>(keys);
+    auto allocations_flat = CountInsertAllocations<TagMap>(keys);
+    std::printf(
+        "%4zu %10.1f ns %10.1f ns %12zu %12zu %10.1f ns %10.1f ns %10.1f ns "
+        "%10.1f ns %10.1f ns\n",
+        num_tags, insert_map, insert_flat, allocations_map, allocations_flat,
+        lookup_map, lookup_flat, json_map, json_flat, to_json);
+  }
+  return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+// Times TailSamplingRecorder::RecordSpan for traces of different sizes whose
+// spans finish in order, so that each trace is decided when its root span is
+// recorded. Half of the traces have a root whose operation name keeps them,
+// and the other half are dropped; kept spans are forwarded to a recorder that
+// discards them. The time per span includes buffering the span, deciding its
+// trace and forwarding it.
+//
+// Usage: tail_sampling_benchmark [traces]
+//
+// Build with optimizations, e.g. CMAKE_BUILD_TYPE=Release, for meaningful
+// times.
+
+#include <opentracing/mocktracer/tail_sampling_recorder.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using opentracing::SpanReferenceType;
+using opentracing::SteadyClock;
+using opentracing::mocktracer::Recorder;
+using opentracing::mocktracer::SpanData;
+using opentracing::mocktracer::TailSamplingOptions;
+using opentracing::mocktracer::TailSamplingRecorder;
+
+namespace {
+class NullRecorder : public Recorder {
+ public:
+  explicit NullRecorder(size_t& num_spans) : num_spans_(num_spans) {}
+
+  void RecordSpan(SpanData&& /*span_data*/) noexcept override {
+    ++num_spans_;
+  }
+
+ private:
+  size_t& num_spans_;
+};
+
+// Returns the spans of a trace, with the root last.
+std::vector<SpanData> MakeTrace(uint64_t trace_id, size_t num_spans,
+                                bool is_kept) {
+  std::vector<SpanData> spans(num_spans);
+  for (size_t i = 0; i < num_spans; ++i) {
+    auto& span_data = spans[i];
+    span_data.span_context.trace_id = trace_id;
+    span_data.span_context.span_id = num_spans - i;
+    span_data.operation_name = "span";
+    span_data.duration = std::chrono::milliseconds{1};
+    if (i + 1 < num_spans) {
+      span_data.references.push_back(
+          {SpanReferenceType::ChildOfRef, trace_id, 1});
+    }
+  }
+  if (is_kept) {
+    spans.back().operation_name = "keep";
+  }
+  return spans;
+}
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t num_traces = 100000;
+  if (argc > 1) {
+    num_traces = std::strtoul(argv[1], nullptr, 10);
+  }
+  std::printf("%10s %13s %13s %12s\n", "trace size", "per span",
+              "per trace", "forwarded");
+  for (size_t trace_size : {1, 4, 16, 64}) {
+    std::vector<std::vector<SpanData>> traces;
+    traces.reserve(num_traces);
+    for (size_t i = 0; i < num_traces; ++i) {
+      traces.emplace_back(MakeTrace(i * 0x9e3779b97f4a7c15, trace_size,
+                                    i % 2 == 0));
+    }
+
+    size_t num_forwarded = 0;
+    TailSamplingOptions options;
+    options.operation_names = {"keep"};
+    options.keep_errors = false;
+    options.timeout_check_interval = SteadyClock::duration::zero();
+    TailSamplingRecorder recorder{
+        std::unique_ptr<Recorder>{new NullRecorder{num_forwarded}}, options};
+
+    auto start = SteadyClock::now();
+    for (auto& spans : traces) {
+      for (auto& span_data : spans) {
+        recorder.RecordSpan(std::move(span_data));
+      }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       SteadyClock::now() - start)
+                       .count();
+    recorder.Close();
+    std::printf("%10zu %10.1f ns %10.1f ns %12zu\n", trace_size,
+                elapsed / static_cast<double>(num_traces * trace_size),
+                elapsed / static_cast<double>(num_traces), num_forwarded);
+  }
+  return 0;
+}
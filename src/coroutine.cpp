@@ -0,0 +1,9 @@
+#include <opentracing/coroutine.h>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+static thread_local CoroutineHandoff coroutine_handoff{nullptr, nullptr};
+
+CoroutineHandoff& GetCoroutineHandoff() noexcept { return coroutine_handoff; }
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
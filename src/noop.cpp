@@ -12,6 +12,8 @@ class NoopSpanContext : public SpanContext {
   std::unique_ptr<SpanContext> Clone() const noexcept override {
     return std::unique_ptr<SpanContext>{new (std::nothrow) NoopSpanContext{}};
   }
+
+  bool IsSampled() const noexcept override { return false; }
 };
 
 class NoopSpan : public Span {
@@ -49,6 +51,8 @@ class NoopSpan : public Span {
 
   const Tracer& tracer() const noexcept override { return *tracer_; }
 
+  bool IsRecording() const noexcept override { return false; }
+
  private:
   std::shared_ptr<const Tracer> tracer_;
   NoopSpanContext span_context_;
@@ -0,0 +1,60 @@
+#include <opentracing/scope_manager.h>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+static thread_local Span* active_span = nullptr;
+
+// The shared_ptr the active span was activated through, or nullptr if it was
+// activated by reference.
+static thread_local const std::shared_ptr<Span>* active_span_owner = nullptr;
+
+Scope::Scope(Scope&& other) noexcept
+    : span_{other.span_},
+      previous_span_{other.previous_span_},
+      previous_owner_{other.previous_owner_},
+      is_open_{other.is_open_} {
+  other.is_open_ = false;
+}
+
+Scope::~Scope() { Close(); }
+
+void Scope::Close() noexcept {
+  if (!is_open_) {
+    return;
+  }
+  active_span = previous_span_;
+  active_span_owner = previous_owner_;
+  is_open_ = false;
+}
+
+Scope ScopeManager::Activate(Span& span) noexcept {
+  Scope scope{span, active_span, active_span_owner};
+  active_span = &span;
+  active_span_owner = nullptr;
+  return scope;
+}
+
+Scope ScopeManager::Activate(const std::shared_ptr<Span>& span) noexcept {
+  Scope scope{*span, active_span, active_span_owner};
+  active_span = span.get();
+  active_span_owner = &span;
+  return scope;
+}
+
+Span* ScopeManager::ActiveSpan() noexcept { return active_span; }
+
+std::shared_ptr<Span> ScopeManager::ActiveSpanOwner() noexcept {
+  if (active_span_owner == nullptr) {
+    return nullptr;
+  }
+  return *active_span_owner;
+}
+
+Span* ScopeManager::SetActiveSpan(Span* span) noexcept {
+  auto previous_span = active_span;
+  active_span = span;
+  active_span_owner = nullptr;
+  return previous_span;
+}
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
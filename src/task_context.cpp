@@ -0,0 +1,151 @@
+#include <opentracing/task_context.h>
+#include <atomic>
+#include <exception>
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+namespace {
+// CapturedSpan stands in for a span that was activated by reference, whose
+// context a TaskContext cloned since the span may have finished and been
+// destroyed by the time the task runs.
+class CapturedSpan : public Span {
+ public:
+  CapturedSpan(std::shared_ptr<const Tracer>&& tracer,
+               std::unique_ptr<SpanContext>&& span_context) noexcept
+      : tracer_(std::move(tracer)), span_context_(std::move(span_context)) {}
+
+  void FinishWithOptions(
+      const FinishSpanOptions& /*options*/) noexcept override {}
+
+  void SetOperationName(string_view /*name*/) noexcept override {}
+
+  void SetTag(string_view /*key*/, const Value& /*value*/) noexcept override {}
+
+  void SetBaggageItem(string_view /*restricted_key*/,
+                      string_view /*value*/) noexcept override {}
+
+  std::string BaggageItem(string_view restricted_key) const
+      noexcept override try {
+    std::string result;
+    span_context_->ForeachBaggageItem(
+        [&](const std::string& key, const std::string& value) {
+          if (key != restricted_key) {
+            return true;
+          }
+          result = value;
+          return false;
+        });
+    return result;
+  } catch (const std::exception& /*e*/) {
+    return {};
+  }
+
+  void Log(std::initializer_list<std::pair<string_view, Value>>
+           /*fields*/) noexcept override {}
+
+  void Log(SystemTime /*timestamp*/,
+           std::initializer_list<std::pair<string_view, Value>>
+           /*fields*/) noexcept override {}
+
+  void Log(SystemTime /*timestamp*/,
+           const std::vector<std::pair<string_view, Value>>&
+           /*fields*/) noexcept override {}
+
+  const SpanContext& context() const noexcept override {
+    return *span_context_;
+  }
+
+  const Tracer& tracer() const noexcept override { return *tracer_; }
+
+  bool IsRecording() const noexcept override { return false; }
+
+ private:
+  std::shared_ptr<const Tracer> tracer_;
+  std::unique_ptr<SpanContext> span_context_;
+};
+
+std::shared_ptr<const Tracer> GetTracer(const TaskContextOptions& options) {
+  if (options.tracer != nullptr) {
+    return options.tracer;
+  }
+  return Tracer::Global();
+}
+}  // anonymous namespace
+
+class TaskContext::SharedState {
+ public:
+  SharedState(std::shared_ptr<const Tracer>&& tracer,
+              const TaskContextOptions& options)
+      : tracer_(std::move(tracer)),
+        queue_wait_operation_name_(options.queue_wait_operation_name),
+        run_operation_name_(options.run_operation_name) {
+    if (!queue_wait_operation_name_.empty()) {
+      submit_system_timestamp_ = SystemClock::now();
+      submit_steady_timestamp_ = SteadyClock::now();
+    }
+  }
+
+  std::shared_ptr<Span> StartRunSpan(const SpanContext& parent) noexcept;
+
+ private:
+  std::shared_ptr<const Tracer> tracer_;
+  std::string queue_wait_operation_name_;
+  std::string run_operation_name_;
+  SystemTime submit_system_timestamp_;
+  SteadyTime submit_steady_timestamp_;
+  std::atomic<bool> is_queue_wait_recorded_{false};
+};
+
+std::shared_ptr<Span> TaskContext::SharedState::StartRunSpan(
+    const SpanContext& parent) noexcept try {
+  if (!queue_wait_operation_name_.empty() &&
+      !is_queue_wait_recorded_.exchange(true, std::memory_order_relaxed)) {
+    auto queue_wait_span = tracer_->StartSpan(
+        queue_wait_operation_name_,
+        {ChildOf(&parent),
+         StartTimestamp{submit_system_timestamp_, submit_steady_timestamp_}});
+    if (queue_wait_span != nullptr) {
+      queue_wait_span->Finish();
+    }
+  }
+  if (run_operation_name_.empty()) {
+    return nullptr;
+  }
+  // Run spans are activated through a shared_ptr so that tasks submitted
+  // while they're active share them too.
+  return tracer_->StartSpan(run_operation_name_, {ChildOf(&parent)});
+} catch (const std::exception& /*e*/) {
+  return nullptr;
+}
+
+TaskContext::TaskContext(const TaskContextOptions& options) noexcept {
+  auto active_span = ScopeManager::ActiveSpan();
+  if (active_span == nullptr) {
+    return;
+  }
+  try {
+    span_ = ScopeManager::ActiveSpanOwner();
+    if (span_ == nullptr) {
+      auto span_context = active_span->context().Clone();
+      if (span_context == nullptr) {
+        return;
+      }
+      span_ = std::make_shared<CapturedSpan>(GetTracer(options),
+                                             std::move(span_context));
+    }
+    if (!options.queue_wait_operation_name.empty() ||
+        !options.run_operation_name.empty()) {
+      state_ = std::make_shared<SharedState>(GetTracer(options), options);
+    }
+  } catch (const std::exception& /*e*/) {
+    // Run the task without the context.
+    span_.reset();
+    state_.reset();
+  }
+}
+
+std::shared_ptr<Span> TaskContext::StartRunSpan() noexcept {
+  return state_->StartRunSpan(span_->context());
+}
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
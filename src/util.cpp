@@ -0,0 +1,90 @@
+#include <opentracing/util.h>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+namespace opentracing {
+BEGIN_OPENTRACING_ABI_NAMESPACE
+static const int64_t kRefreshPeriod =
+    std::chrono::nanoseconds{std::chrono::seconds{1}}.count();
+
+static const int64_t kUnmeasured = std::numeric_limits<int64_t>::min();
+
+// The system time minus the steady time, and the steady time it was measured
+// at, in nanoseconds. They're updated separately, so a reader may pair an
+// offset with the time of a neighboring measurement, which only affects when
+// the next refresh happens.
+//
+// Only the current time decides when the offset is refreshed, never the time
+// being converted, so converting times far from now costs the same as
+// converting the current time.
+static std::atomic<int64_t> clock_offset{0};
+static std::atomic<int64_t> clock_offset_timestamp{kUnmeasured};
+
+// Set while a conversion refreshes the offset, so that concurrent conversions
+// use the previous offset instead of all measuring it at once.
+static std::atomic<bool> is_refreshing_clock_offset{false};
+
+template <class Clock>
+static int64_t ToNanoseconds(typename Clock::time_point time_point) noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time_point.time_since_epoch())
+      .count();
+}
+
+void RefreshClockOffset() noexcept {
+  // Read the system clock between two reads of the steady clock, and keep the
+  // sample with the two closest together, whose midpoint is most likely to be
+  // when the system clock was read.
+  int64_t best_gap = std::numeric_limits<int64_t>::max();
+  int64_t best_offset = 0;
+  int64_t best_timestamp = 0;
+  for (int i = 0; i < 3; ++i) {
+    auto steady_before = ToNanoseconds<SteadyClock>(SteadyClock::now());
+    auto system_now = ToNanoseconds<SystemClock>(SystemClock::now());
+    auto steady_after = ToNanoseconds<SteadyClock>(SteadyClock::now());
+    auto gap = steady_after - steady_before;
+    if (gap < best_gap) {
+      best_gap = gap;
+      best_timestamp = steady_before + gap / 2;
+      best_offset = system_now - best_timestamp;
+    }
+  }
+  clock_offset.store(best_offset, std::memory_order_relaxed);
+  clock_offset_timestamp.store(best_timestamp, std::memory_order_relaxed);
+}
+
+// Returns the steady clock's time from a cheaper, coarser clock if there's
+// one, for deciding when to refresh the offset. On Linux, the steady clock
+// reads CLOCK_MONOTONIC, which CLOCK_MONOTONIC_COARSE follows a few
+// milliseconds behind without a hardware clock read.
+static int64_t CoarseSteadyNow() noexcept {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &now) == 0) {
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+  }
+#endif
+  return ToNanoseconds<SteadyClock>(SteadyClock::now());
+}
+
+std::chrono::nanoseconds GetClockOffset() noexcept {
+  auto timestamp = clock_offset_timestamp.load(std::memory_order_relaxed);
+  if (timestamp == kUnmeasured) {
+    RefreshClockOffset();
+  } else if (CoarseSteadyNow() - timestamp > kRefreshPeriod) {
+    if (!is_refreshing_clock_offset.exchange(true,
+                                             std::memory_order_acquire)) {
+      RefreshClockOffset();
+      is_refreshing_clock_offset.store(false, std::memory_order_release);
+    }
+  }
+  return std::chrono::nanoseconds{
+      clock_offset.load(std::memory_order_relaxed)};
+}
+END_OPENTRACING_ABI_NAMESPACE
+}  // namespace opentracing
@@ -0,0 +1,194 @@
+#include <opentracing/coroutine.h>
+#include <opentracing/noop.h>
+#include <opentracing/scope_manager.h>
+#include <chrono>
+#include <thread>
+#include <utility>
+using namespace opentracing;
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+
+#ifdef OPENTRACING_HAS_COROUTINES
+namespace {
+struct Task {
+  struct promise_type {
+    Task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+// LazyTask is a coroutine that starts when it's awaited, and resumes its
+// awaiter by symmetric transfer when it finishes.
+struct LazyTask {
+  struct promise_type {
+    std::coroutine_handle<> continuation;
+
+    LazyTask get_return_object() noexcept {
+      return LazyTask{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        auto continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+      }
+      void await_resume() const noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  explicit LazyTask(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_{handle} {}
+
+  LazyTask(LazyTask&& other) noexcept
+      : handle_{std::exchange(other.handle_, nullptr)} {}
+
+  ~LazyTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> continuation) noexcept {
+    handle_.promise().continuation = continuation;
+    return handle_;
+  }
+
+  void await_resume() const noexcept {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Resumes the awaiting coroutine on a new thread after a delay.
+struct ResumeOnThread {
+  std::thread& thread;
+  Span*& active_span_after_resume;
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    thread = std::thread{[this, handle] {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      handle.resume();
+      active_span_after_resume = ScopeManager::ActiveSpan();
+    }};
+  }
+
+  void await_resume() const noexcept {}
+};
+
+struct Observations {
+  Span* active_span_before = nullptr;
+  Span* active_span_ready = nullptr;
+  Span* active_span_resumed = nullptr;
+  Span* active_span_after_resume = reinterpret_cast<Span*>(1);
+  SteadyClock::duration suspended_duration{};
+};
+
+Task RunCoroutine(Span& span, std::thread& thread,
+                  Observations& observations) {
+  CoroutineScope scope{span};
+  observations.active_span_before = ScopeManager::ActiveSpan();
+  co_await scope.Await(std::suspend_never{});
+  observations.active_span_ready = ScopeManager::ActiveSpan();
+  co_await scope.Await(
+      ResumeOnThread{thread, observations.active_span_after_resume});
+  observations.active_span_resumed = ScopeManager::ActiveSpan();
+  observations.suspended_duration = scope.suspended_duration();
+}
+LazyTask RunLazyChild(Span*& active_span) {
+  active_span = ScopeManager::ActiveSpan();
+  co_return;
+}
+
+LazyTask RunSuspendingLazyChild(Span& span, std::thread& thread,
+                                Observations& observations) {
+  CoroutineScope scope{span};
+  observations.active_span_before = ScopeManager::ActiveSpan();
+  co_await scope.Await(
+      ResumeOnThread{thread, observations.active_span_after_resume});
+  observations.active_span_ready = ScopeManager::ActiveSpan();
+}
+
+Task RunLazyParent(Span& span, Span*& active_span_in_child,
+                   Span*& active_span_after_child) {
+  CoroutineScope scope{span};
+  co_await scope.Await(RunLazyChild(active_span_in_child));
+  active_span_after_child = ScopeManager::ActiveSpan();
+}
+
+Task RunSuspendingLazyParent(Span& span, Span& child_span,
+                             std::thread& thread, Observations& observations,
+                             Span*& active_span_after_child) {
+  CoroutineScope scope{span};
+  co_await scope.Await(
+      RunSuspendingLazyChild(child_span, thread, observations));
+  active_span_after_child = ScopeManager::ActiveSpan();
+}
+}  // anonymous namespace
+
+TEST_CASE("coroutine") {
+  auto tracer = MakeNoopTracer();
+  auto span_a = tracer->StartSpan("a");
+  auto span_b = tracer->StartSpan("b");
+
+  SECTION("The span is active only while the coroutine runs.") {
+    auto scope = ScopeManager::Activate(*span_a);
+    std::thread thread;
+    Observations observations;
+    RunCoroutine(*span_b, thread, observations);
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+    thread.join();
+    CHECK(observations.active_span_before == span_b.get());
+    CHECK(observations.active_span_ready == span_b.get());
+    CHECK(observations.active_span_resumed == span_b.get());
+    CHECK(observations.active_span_after_resume == nullptr);
+    CHECK(observations.suspended_duration >= std::chrono::milliseconds{10});
+  }
+
+  SECTION("Lazily started coroutines run with the span active.") {
+    auto scope = ScopeManager::Activate(*span_a);
+    Span* active_span_in_child = nullptr;
+    Span* active_span_after_child = nullptr;
+    RunLazyParent(*span_b, active_span_in_child, active_span_after_child);
+    CHECK(active_span_in_child == span_b.get());
+    CHECK(active_span_after_child == span_b.get());
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+  }
+
+  SECTION("Lazily started coroutines give the thread back when suspended.") {
+    auto span_c = tracer->StartSpan("c");
+    auto scope = ScopeManager::Activate(*span_a);
+    std::thread thread;
+    Observations observations;
+    Span* active_span_after_child = nullptr;
+    RunSuspendingLazyParent(*span_b, *span_c, thread, observations,
+                            active_span_after_child);
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+    thread.join();
+    CHECK(observations.active_span_before == span_c.get());
+    CHECK(observations.active_span_ready == span_c.get());
+    CHECK(active_span_after_child == span_b.get());
+    CHECK(observations.active_span_after_resume == nullptr);
+  }
+}
+#else
+TEST_CASE("coroutine") {
+  // Coroutines aren't supported by this compiler.
+  CHECK(true);
+}
+#endif
@@ -0,0 +1,86 @@
+#include <opentracing/noop.h>
+#include <opentracing/scope_manager.h>
+#include <thread>
+#include <utility>
+using namespace opentracing;
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+
+TEST_CASE("scope_manager") {
+  auto tracer = MakeNoopTracer();
+  auto span_a = tracer->StartSpan("a");
+  auto span_b = tracer->StartSpan("b");
+
+  SECTION("No span is active initially.") {
+    CHECK(ScopeManager::ActiveSpan() == nullptr);
+  }
+
+  SECTION("Closing a scope reactivates the span active before it.") {
+    {
+      auto scope_a = ScopeManager::Activate(*span_a);
+      CHECK(ScopeManager::ActiveSpan() == span_a.get());
+      CHECK(&scope_a.span() == span_a.get());
+      {
+        auto scope_b = ScopeManager::Activate(*span_b);
+        CHECK(ScopeManager::ActiveSpan() == span_b.get());
+      }
+      CHECK(ScopeManager::ActiveSpan() == span_a.get());
+    }
+    CHECK(ScopeManager::ActiveSpan() == nullptr);
+  }
+
+  SECTION("A scope can be closed early and moved.") {
+    auto scope_a = ScopeManager::Activate(*span_a);
+    auto scope_b = ScopeManager::Activate(*span_b);
+    auto moved_scope_b = std::move(scope_b);
+    CHECK(ScopeManager::ActiveSpan() == span_b.get());
+    moved_scope_b.Close();
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+    moved_scope_b.Close();
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+  }
+
+  SECTION("Each thread has its own active span.") {
+    auto scope_a = ScopeManager::Activate(*span_a);
+    Span* other_active_span = span_a.get();
+    std::thread thread{[&] {
+      auto scope_b = ScopeManager::Activate(*span_b);
+      other_active_span = ScopeManager::ActiveSpan();
+    }};
+    thread.join();
+    CHECK(other_active_span == span_b.get());
+    CHECK(ScopeManager::ActiveSpan() == span_a.get());
+  }
+
+  SECTION("Spans activated through a shared_ptr have an owner.") {
+    std::shared_ptr<Span> shared_span_a{std::move(span_a)};
+    CHECK(ScopeManager::ActiveSpanOwner() == nullptr);
+    auto scope_a = ScopeManager::Activate(shared_span_a);
+    CHECK(ScopeManager::ActiveSpan() == shared_span_a.get());
+    CHECK(ScopeManager::ActiveSpanOwner() == shared_span_a);
+    {
+      auto scope_b = ScopeManager::Activate(*span_b);
+      CHECK(ScopeManager::ActiveSpanOwner() == nullptr);
+    }
+    CHECK(ScopeManager::ActiveSpanOwner() == shared_span_a);
+    auto previous_span = ScopeManager::SetActiveSpan(span_b.get());
+    CHECK(ScopeManager::ActiveSpanOwner() == nullptr);
+    ScopeManager::SetActiveSpan(previous_span);
+    scope_a.Close();
+    CHECK(ScopeManager::ActiveSpanOwner() == nullptr);
+  }
+
+  SECTION("ChildOfActiveSpan references the active span's context.") {
+    StartSpanOptions options;
+    ChildOfActiveSpan{}.Apply(options);
+    CHECK(options.references.empty());
+
+    auto scope_a = ScopeManager::Activate(*span_a);
+    ChildOfActiveSpan{}.Apply(options);
+    REQUIRE(options.references.size() == 1);
+    CHECK(options.references[0].first == SpanReferenceType::ChildOfRef);
+    CHECK(options.references[0].second == &span_a->context());
+    CHECK(tracer->StartSpan("c", {ChildOfActiveSpan{}}));
+  }
+}
@@ -0,0 +1,79 @@
+#include <opentracing/noop.h>
+#include <opentracing/task_context.h>
+#include <functional>
+#include <memory>
+#include <thread>
+using namespace opentracing;
+
+#define CATCH_CONFIG_MAIN
+#include <opentracing/catch2/catch.hpp>
+
+TEST_CASE("task_context") {
+  auto tracer = MakeNoopTracer();
+
+  SECTION("Nothing is captured if no span is active.") {
+    TaskContext task_context;
+    CHECK(task_context.span() == nullptr);
+    auto task = MakeContextTask([] { return ScopeManager::ActiveSpan(); });
+    CHECK(task() == nullptr);
+  }
+
+  SECTION("Tasks run with the captured context active on another thread.") {
+    auto span = tracer->StartSpan("a");
+    TaskContextOptions options;
+    options.tracer = tracer;
+    std::function<const Span*(int)> task;
+    {
+      auto scope = ScopeManager::Activate(*span);
+      task = MakeContextTask(
+          [](int x) {
+            CHECK(x == 123);
+            return ScopeManager::ActiveSpan();
+          },
+          options);
+    }
+    CHECK(ScopeManager::ActiveSpan() == nullptr);
+    const Span* active_span = nullptr;
+    std::thread thread{[&] { active_span = task(123); }};
+    thread.join();
+    REQUIRE(active_span != nullptr);
+    CHECK(active_span != span.get());
+    CHECK(!active_span->IsRecording());
+    CHECK(&active_span->tracer() == tracer.get());
+    CHECK(ScopeManager::ActiveSpan() == nullptr);
+  }
+
+  SECTION("Tasks share spans activated through a shared_ptr.") {
+    std::shared_ptr<Span> span{tracer->StartSpan("a")};
+    std::function<std::shared_ptr<Span>()> task;
+    {
+      auto scope = ScopeManager::Activate(span);
+      task = MakeContextTask([] { return ScopeManager::ActiveSpanOwner(); });
+    }
+    auto weak_span = std::weak_ptr<Span>{span};
+    span.reset();
+    CHECK(!weak_span.expired());
+    std::shared_ptr<Span> active_span;
+    std::thread thread{[&] { active_span = task(); }};
+    thread.join();
+    CHECK(active_span == weak_span.lock());
+    task = nullptr;
+    active_span.reset();
+    CHECK(weak_span.expired());
+  }
+
+  SECTION("Run spans are active while the task runs.") {
+    auto span = tracer->StartSpan("a");
+    auto scope = ScopeManager::Activate(*span);
+    TaskContextOptions options;
+    options.queue_wait_operation_name = "queue_wait";
+    options.run_operation_name = "run";
+    TaskContext task_context{options};
+    REQUIRE(task_context.span() != nullptr);
+    auto f = [] { return ScopeManager::ActiveSpan(); };
+    auto active_span = task_context.Run(f);
+    CHECK(active_span != nullptr);
+    CHECK(active_span != task_context.span());
+    CHECK(ScopeManager::ActiveSpan() == span.get());
+  }
+}
@@ -28,6 +28,11 @@ TEST_CASE("tracer") {
     span2->Finish();
   }
 
+  SECTION("Noop spans aren't recording.") {
+    CHECK(!span1->IsRecording());
+    CHECK(!span1->context().IsSampled());
+  }
+
   SECTION("A reference to a null SpanContext is ignored.") {
     StartSpanOptions options;
     ChildOf(nullptr).Apply(options);
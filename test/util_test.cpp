@@ -19,6 +19,40 @@ TEST_CASE("convert_time_point") {
     CHECK(difference < 100);
   }
 
+  SECTION("Conversions between refreshes use the same offset") {
+    RefreshClockOffset();
+    auto t1 = SteadyClock::now();
+    auto t2 = t1 + std::chrono::milliseconds{1};
+    auto system_t1 = convert_time_point<SystemClock>(t1);
+    auto system_t2 = convert_time_point<SystemClock>(t2);
+    CHECK(system_t2 - system_t1 == std::chrono::milliseconds{1});
+    // system_t1 is truncated to the resolution of the system clock.
+    auto round_trip_error = t1 - convert_time_point<SteadyClock>(system_t1);
+    CHECK(round_trip_error >= SteadyClock::duration::zero());
+    CHECK(round_trip_error < SystemClock::duration{1});
+  }
+
+  SECTION("Converting times far from now doesn't refresh the clock offset") {
+    RefreshClockOffset();
+    auto offset = GetClockOffset();
+    auto now = SteadyClock::now();
+    convert_time_point<SystemClock>(now + std::chrono::hours{1});
+    convert_time_point<SystemClock>(now - std::chrono::hours{1});
+    CHECK(GetClockOffset() == offset);
+  }
+
+  SECTION("The clock offset follows the system clock") {
+    RefreshClockOffset();
+    auto system_now = SystemClock::now();
+    auto steady_now = SteadyClock::now();
+    auto error = std::abs(std::chrono::duration_cast<std::chrono::microseconds>(
+                              GetClockOffset() -
+                              (system_now.time_since_epoch() -
+                               steady_now.time_since_epoch()))
+                              .count());
+    CHECK(error < 1000);
+  }
+
   SECTION("Converting times from the same clock gives the identity") {
     auto t = SystemClock::now();
     CHECK(t == convert_time_point<SystemClock>(t));